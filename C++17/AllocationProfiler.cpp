@@ -0,0 +1,246 @@
+#include "AllocationProfiler.h"
+
+#include <cstdlib>
+#include <new>
+
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+
+/*
+ Перед каждым блоком хранится его размер: operator delete без размера должен знать, сколько байт освобождается.
+ Обычный new: заголовок __STDCPP_DEFAULT_NEW_ALIGNMENT__ байт перед блоком, выделение через malloc.
+ new с выравниванием (align_val_t): заголовок размером в выравнивание, выделение через aligned_alloc (_aligned_malloc в Windows).
+ */
+
+namespace allocation_profiler
+{
+    void OnAllocate(uint64_t size) noexcept;
+
+    namespace
+    {
+        /// Только тривиальные типы: thread_local с конструктором мог бы сам вызвать operator new
+        thread_local Counters thread_counters;
+        thread_local Scope* current_scope = nullptr;
+
+        constexpr size_t default_alignment = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+        void* Allocate(size_t size, size_t alignment) noexcept
+        {
+            alignment = alignment < default_alignment ? default_alignment : alignment;
+            if (size > SIZE_MAX - 2 * alignment)
+                return nullptr;
+
+            void* base;
+            if (alignment == default_alignment)
+            {
+                base = std::malloc(size + alignment);
+            }
+            else
+            {
+#if defined(_WIN32)
+                base = _aligned_malloc(size + alignment, alignment);
+#else
+                base = std::aligned_alloc(alignment, (size + 2 * alignment - 1) / alignment * alignment);
+#endif
+            }
+            if (!base)
+                return nullptr;
+
+            auto* block = static_cast<char*>(base) + alignment;
+            *reinterpret_cast<size_t*>(block - sizeof(size_t)) = size;
+            OnAllocate(size);
+            return block;
+        }
+
+        void Deallocate(void* pointer, size_t alignment) noexcept
+        {
+            if (!pointer)
+                return;
+
+            alignment = alignment < default_alignment ? default_alignment : alignment;
+            auto* block = static_cast<char*>(pointer);
+            size_t size = *reinterpret_cast<size_t*>(block - sizeof(size_t));
+            ++thread_counters.deallocations;
+            thread_counters.live_bytes -= static_cast<int64_t>(size);
+
+#if defined(_WIN32)
+            if (alignment != default_alignment)
+            {
+                _aligned_free(block - alignment);
+                return;
+            }
+#endif
+            std::free(block - alignment);
+        }
+
+        void* AllocateOrThrow(size_t size, size_t alignment)
+        {
+            while (true)
+            {
+                if (void* pointer = Allocate(size ? size : 1, alignment))
+                    return pointer;
+
+                std::new_handler handler = std::get_new_handler();
+                if (!handler)
+                    throw std::bad_alloc();
+                handler();
+            }
+        }
+    }
+
+    void OnAllocate(uint64_t size) noexcept
+    {
+        Counters& counters = thread_counters;
+        ++counters.allocations;
+        counters.bytes += size;
+        counters.live_bytes += static_cast<int64_t>(size);
+        if (counters.live_bytes > counters.peak_live_bytes)
+            counters.peak_live_bytes = counters.live_bytes;
+
+        // Пик обновляется только у самой внутренней области, внешним он передается в ~Scope
+        if (Scope* scope = current_scope)
+        {
+            int64_t live = counters.live_bytes - scope->_start.live_bytes;
+            if (live > scope->_peak)
+                scope->_peak = live;
+        }
+    }
+
+    Counters ThreadCounters() noexcept
+    {
+        return thread_counters;
+    }
+
+    Scope::Scope(std::string_view name, std::ostream* out) noexcept : _name(name), _out(out), _parent(current_scope), _start(thread_counters)
+    {
+        current_scope = this;
+    }
+
+    Scope::~Scope()
+    {
+        Counters result = counters();
+        current_scope = _parent;
+        if (_parent)
+        {
+            int64_t peak = _start.live_bytes - _parent->_start.live_bytes + _peak;
+            if (peak > _parent->_peak)
+                _parent->_peak = peak;
+        }
+
+        if (_out)
+            WriteJson(*_out, _name, result);
+    }
+
+    Counters Scope::counters() const noexcept
+    {
+        const Counters& now = thread_counters;
+        Counters result;
+        result.allocations = now.allocations - _start.allocations;
+        result.deallocations = now.deallocations - _start.deallocations;
+        result.bytes = now.bytes - _start.bytes;
+        result.live_bytes = now.live_bytes - _start.live_bytes;
+        result.peak_live_bytes = _peak;
+        return result;
+    }
+}
+
+void* operator new(size_t size)
+{
+    return allocation_profiler::AllocateOrThrow(size, 0);
+}
+
+void* operator new[](size_t size)
+{
+    return allocation_profiler::AllocateOrThrow(size, 0);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    return allocation_profiler::Allocate(size ? size : 1, 0);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return allocation_profiler::Allocate(size ? size : 1, 0);
+}
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+    return allocation_profiler::AllocateOrThrow(size, static_cast<size_t>(alignment));
+}
+
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+    return allocation_profiler::AllocateOrThrow(size, static_cast<size_t>(alignment));
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return allocation_profiler::Allocate(size ? size : 1, static_cast<size_t>(alignment));
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return allocation_profiler::Allocate(size ? size : 1, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* pointer) noexcept
+{
+    allocation_profiler::Deallocate(pointer, 0);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+    allocation_profiler::Deallocate(pointer, 0);
+}
+
+void operator delete(void* pointer, size_t) noexcept
+{
+    allocation_profiler::Deallocate(pointer, 0);
+}
+
+void operator delete[](void* pointer, size_t) noexcept
+{
+    allocation_profiler::Deallocate(pointer, 0);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept
+{
+    allocation_profiler::Deallocate(pointer, 0);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept
+{
+    allocation_profiler::Deallocate(pointer, 0);
+}
+
+void operator delete(void* pointer, std::align_val_t alignment) noexcept
+{
+    allocation_profiler::Deallocate(pointer, static_cast<size_t>(alignment));
+}
+
+void operator delete[](void* pointer, std::align_val_t alignment) noexcept
+{
+    allocation_profiler::Deallocate(pointer, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* pointer, size_t, std::align_val_t alignment) noexcept
+{
+    allocation_profiler::Deallocate(pointer, static_cast<size_t>(alignment));
+}
+
+void operator delete[](void* pointer, size_t, std::align_val_t alignment) noexcept
+{
+    allocation_profiler::Deallocate(pointer, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* pointer, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    allocation_profiler::Deallocate(pointer, static_cast<size_t>(alignment));
+}
+
+void operator delete[](void* pointer, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    allocation_profiler::Deallocate(pointer, static_cast<size_t>(alignment));
+}
@@ -0,0 +1,105 @@
+#ifndef AllocationProfiler_h
+#define AllocationProfiler_h
+
+#include "JsonString.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string_view>
+#include <thread>
+
+/*
+ Подсчет выделений памяти в куче: глобальные operator new/delete подменены в AllocationProfiler.cpp (файл нужно добавить в сборку).
+ Каждый new/delete обновляет счетчики текущего потока (thread_local) - без блокировок и атомарных операций.
+ Scope (RAII) запоминает счетчики при создании и считает для своей области: количество выделений/освобождений, байты и пиковый объем живой памяти.
+ Вложенные Scope учитываются и во внешнем: пик внутренней области передается наружу при ее завершении.
+ Если передан поток вывода, при завершении области пишется строка JSON (JSON lines):
+ {"scope":"split","thread":1,"allocations":3,"deallocations":3,"bytes":96,"peak_live_bytes":64,"live_bytes":0}
+ Строка собирается через std::to_chars в буфере на стеке, чтобы вывод сам не выделял память.
+ Память освобожденная не в том потоке, где была выделена, уменьшает живой объем освободившего потока.
+ */
+
+namespace allocation_profiler
+{
+    struct Counters
+    {
+        uint64_t allocations = 0;
+        uint64_t deallocations = 0;
+        uint64_t bytes = 0;          // всего выделено байт
+        int64_t live_bytes = 0;      // выделено - освобождено
+        int64_t peak_live_bytes = 0; // максимум live_bytes
+    };
+
+    /// Счетчики текущего потока с его запуска
+    Counters ThreadCounters() noexcept;
+
+    class Scope
+    {
+    public:
+        explicit Scope(std::string_view name, std::ostream* out = nullptr) noexcept;
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+        /// Счетчики от создания области до текущего момента
+        Counters counters() const noexcept;
+
+        /// Для проверок бюджета: assert(scope.WithinBudget(1));
+        [[nodiscard]] bool WithinBudget(uint64_t max_allocations, uint64_t max_bytes = UINT64_MAX) const noexcept
+        {
+            Counters current = counters();
+            return current.allocations <= max_allocations && current.bytes <= max_bytes;
+        }
+
+        /// Запись счетчиков строкой JSON
+        static void WriteJson(std::ostream& out, std::string_view name, const Counters& counters);
+
+    private:
+        friend void OnAllocate(uint64_t size) noexcept;
+
+        std::string_view _name;
+        std::ostream* _out;
+        Scope* _parent;
+        Counters _start;
+        int64_t _peak = 0; // пик live_bytes относительно _start.live_bytes
+    };
+
+    inline void Scope::WriteJson(std::ostream& out, std::string_view name, const Counters& counters)
+    {
+        char buffer[512];
+        char* p = buffer;
+        char* const last = buffer + sizeof(buffer);
+        auto Append = [&](std::string_view text)
+        {
+            size_t size = std::min<size_t>(text.size(), last - p);
+            p = std::copy_n(text.data(), size, p);
+        };
+        auto Number = [&](auto value)
+        {
+            p = std::to_chars(p, last, value).ptr;
+        };
+
+        Append("{\"scope\":\"");
+        json::Escape(name.substr(0, 256), Append);
+        Append("\",\"thread\":");
+        Number(std::hash<std::thread::id>()(std::this_thread::get_id()));
+        Append(",\"allocations\":");
+        Number(counters.allocations);
+        Append(",\"deallocations\":");
+        Number(counters.deallocations);
+        Append(",\"bytes\":");
+        Number(counters.bytes);
+        Append(",\"peak_live_bytes\":");
+        Number(counters.peak_live_bytes);
+        Append(",\"live_bytes\":");
+        Number(counters.live_bytes);
+        Append("}\n");
+        out.write(buffer, p - buffer);
+    }
+}
+
+#endif /* AllocationProfiler_h */
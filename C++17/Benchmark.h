@@ -0,0 +1,377 @@
+#ifndef Benchmark_h
+#define Benchmark_h
+
+#include "JsonString.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/*
+ Простейшие замеры времени для сравнения "старого" и "нового" способа.
+ DoNotOptimize - не дает компилятору выбросить вычисление, результат которого не используется.
+
+ Runner - замер со статистикой: число итераций подбирается так, чтобы один замер шел не меньше min_sample_ns,
+ затем warmup прогревочных замеров и repetitions измеряемых. Результат - медиана, перцентили, среднее в наносекундах на итерацию.
+ Аппаратные счетчики (такты, инструкции, промахи кэша и предсказателя ветвлений) читаются через perf_event_open в Linux,
+ если ядро разрешает (/proc/sys/kernel/perf_event_paranoid), иначе не выводятся.
+ */
+
+namespace benchmark
+{
+    template<typename T>
+    inline void DoNotOptimize(const T& value)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : "r,m"(value) : "memory");
+#else
+        static const void* volatile sink;
+        sink = &value;
+#endif
+    }
+
+    /// Время выполнения function в наносекундах
+    template<typename TFunction>
+    inline double Measure(TFunction&& function)
+    {
+        auto start = std::chrono::steady_clock::now();
+        function();
+        auto finish = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(finish - start).count();
+    }
+
+    /// Вывод: имя, размер входных данных, наносекунд на одну операцию
+    inline void Report(std::string_view name, size_t size, double nanoseconds, size_t operations)
+    {
+        std::cout << name << " [" << size << "]: " << nanoseconds / (operations ? operations : 1) << " ns/op" << std::endl;
+    }
+
+    /// Аппаратные счетчики на одну итерацию
+    struct HardwareCounters
+    {
+        double cycles = 0;
+        double instructions = 0;
+        double cache_misses = 0;
+        double branch_misses = 0;
+    };
+
+    /// Группа счетчиков perf_event_open для текущего потока
+    class PerfCounters
+    {
+    public:
+        PerfCounters()
+        {
+#if defined(__linux__)
+            const uint64_t configs[] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+            for (size_t i = 0; i < std::size(configs); ++i)
+            {
+                perf_event_attr attributes {};
+                attributes.type = PERF_TYPE_HARDWARE;
+                attributes.size = sizeof(attributes);
+                attributes.config = configs[i];
+                attributes.disabled = i == 0; // группа включается через лидера
+                attributes.exclude_kernel = 1;
+                attributes.exclude_hv = 1;
+                attributes.read_format = PERF_FORMAT_GROUP;
+                int fd = static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, i == 0 ? -1 : _fds[0], 0));
+                if (fd < 0)
+                {
+                    Close();
+                    return;
+                }
+                _fds[i] = fd;
+            }
+#endif
+        }
+
+        ~PerfCounters()
+        {
+            Close();
+        }
+
+        PerfCounters(const PerfCounters&) = delete;
+        PerfCounters& operator=(const PerfCounters&) = delete;
+
+        bool available() const noexcept { return _fds[0] >= 0; }
+
+        void Start() noexcept
+        {
+#if defined(__linux__)
+            if (available())
+            {
+                ioctl(_fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+                ioctl(_fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+            }
+#endif
+        }
+
+        /// Значения с момента Start(), деленные на iterations
+        std::optional<HardwareCounters> Stop(size_t iterations) noexcept
+        {
+#if defined(__linux__)
+            if (!available())
+                return std::nullopt;
+
+            ioctl(_fds[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+            uint64_t values[5] {}; // количество + 4 значения
+            if (read(_fds[0], values, sizeof(values)) != static_cast<ssize_t>(sizeof(values)))
+                return std::nullopt;
+
+            double n = static_cast<double>(iterations ? iterations : 1);
+            return HardwareCounters {values[1] / n, values[2] / n, values[3] / n, values[4] / n};
+#else
+            (void)iterations;
+            return std::nullopt;
+#endif
+        }
+
+    private:
+        void Close() noexcept
+        {
+#if defined(__linux__)
+            for (int& fd : _fds)
+            {
+                if (fd >= 0)
+                    close(fd);
+                fd = -1;
+            }
+#endif
+        }
+
+        int _fds[4] = {-1, -1, -1, -1};
+    };
+
+    struct Options
+    {
+        size_t warmup = 3;
+        size_t repetitions = 15;
+        double min_sample_ns = 1'000'000; // 1 мс на один замер
+    };
+
+    struct Result
+    {
+        std::string group; // пара "старый способ / новый способ"
+        std::string name;
+        size_t size = 0;
+        size_t iterations = 0; // итераций в одном замере
+        double median = 0;
+        double p10 = 0;
+        double p90 = 0;
+        double p99 = 0;
+        double mean = 0;
+        double min = 0;
+        double max = 0;
+        std::optional<HardwareCounters> counters;
+        std::optional<double> allocations; // выделений памяти на итерацию, если их считает вызывающий
+    };
+
+    /// Перцентиль отсортированной выборки с линейной интерполяцией
+    inline double Percentile(const std::vector<double>& sorted, double percent)
+    {
+        if (sorted.empty())
+            return 0;
+        double position = percent / 100.0 * static_cast<double>(sorted.size() - 1);
+        size_t index = static_cast<size_t>(position);
+        double fraction = position - static_cast<double>(index);
+        return index + 1 < sorted.size() ? sorted[index] * (1 - fraction) + sorted[index + 1] * fraction : sorted[index];
+    }
+
+    class Runner
+    {
+    public:
+        explicit Runner(Options options = Options()) : _options(options) {}
+
+        /// Замер function() как одной итерации, size - размер входных данных для отчета
+        template<typename TFunction>
+        Result& Run(std::string_view group, std::string_view name, size_t size, TFunction&& function)
+        {
+            return Run(group, name, size, NoSetup(), function);
+        }
+
+        /// То же, но перед каждой итерацией вызывается setup() вне замера (сброс кэша, свежая копия данных):
+        /// каждая итерация замеряется отдельно, поэтому подходит для итераций от десятков микросекунд
+        template<typename TSetup, typename TFunction>
+        Result& Run(std::string_view group, std::string_view name, size_t size, TSetup&& setup, TFunction&& function)
+        {
+            auto Sample = [&](size_t iterations)
+            {
+                if constexpr (std::is_same_v<std::decay_t<TSetup>, NoSetup>)
+                {
+                    return Measure([&]()
+                    {
+                        for (size_t i = 0; i < iterations; ++i)
+                            function();
+                    });
+                }
+                else
+                {
+                    double time = 0;
+                    for (size_t i = 0; i < iterations; ++i)
+                    {
+                        setup();
+                        time += Measure(function);
+                    }
+                    return time;
+                }
+            };
+
+            size_t iterations = 1;
+            while (true)
+            {
+                double time = Sample(iterations);
+                if (time >= _options.min_sample_ns || iterations >= (size_t(1) << 30))
+                    break;
+                iterations = time > 0 ? std::max(iterations * 2, static_cast<size_t>(iterations * _options.min_sample_ns / time * 1.2)) : iterations * 16;
+            }
+
+            for (size_t i = 0; i < _options.warmup; ++i)
+                Sample(iterations);
+
+            std::vector<double> samples;
+            samples.reserve(_options.repetitions);
+            for (size_t i = 0; i < std::max<size_t>(_options.repetitions, 1); ++i)
+                samples.push_back(Sample(iterations) / static_cast<double>(iterations));
+
+            Result result;
+            result.group = group;
+            result.name = name;
+            result.size = size;
+            result.iterations = iterations;
+            std::sort(samples.begin(), samples.end());
+            result.median = Percentile(samples, 50);
+            result.p10 = Percentile(samples, 10);
+            result.p90 = Percentile(samples, 90);
+            result.p99 = Percentile(samples, 99);
+            result.min = samples.front();
+            result.max = samples.back();
+            for (double sample : samples)
+                result.mean += sample / static_cast<double>(samples.size());
+
+            if constexpr (std::is_same_v<std::decay_t<TSetup>, NoSetup>)
+            {
+                _perf.Start();
+                Sample(iterations);
+                result.counters = _perf.Stop(iterations);
+            }
+            else
+            {
+                // счетчики - только за function(), без setup()
+                result.counters = HardwareCounters {};
+                for (size_t i = 0; i < iterations && result.counters; ++i)
+                {
+                    setup();
+                    _perf.Start();
+                    function();
+                    std::optional<HardwareCounters> counters = _perf.Stop(iterations);
+                    if (!counters)
+                    {
+                        result.counters.reset();
+                        break;
+                    }
+                    result.counters->cycles += counters->cycles;
+                    result.counters->instructions += counters->instructions;
+                    result.counters->cache_misses += counters->cache_misses;
+                    result.counters->branch_misses += counters->branch_misses;
+                }
+            }
+
+            _results.push_back(std::move(result));
+            return _results.back();
+        }
+
+        const std::vector<Result>& results() const noexcept { return _results; }
+        bool perf_available() const noexcept { return _perf.available(); }
+
+    private:
+        struct NoSetup
+        {
+            void operator()() const noexcept {}
+        };
+
+        Options _options;
+        PerfCounters _perf;
+        std::vector<Result> _results;
+    };
+
+    /// Экранирование строки для CSV: поле в кавычках, кавычка удваивается
+    inline std::string CsvString(std::string_view text)
+    {
+        std::string result = "\"";
+        for (char c : text)
+        {
+            if (c == '"')
+                result += '"';
+            result += c;
+        }
+        return result += '"';
+    }
+
+    inline void WriteJson(std::ostream& out, const std::vector<Result>& results)
+    {
+        out << "[\n";
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            const Result& result = results[i];
+            out << "  {\"group\":" << json::String(result.group) << ",\"name\":" << json::String(result.name) << ",\"size\":" << result.size
+                << ",\"iterations\":" << result.iterations << ",\"median_ns\":" << result.median << ",\"p10_ns\":" << result.p10
+                << ",\"p90_ns\":" << result.p90 << ",\"p99_ns\":" << result.p99 << ",\"mean_ns\":" << result.mean
+                << ",\"min_ns\":" << result.min << ",\"max_ns\":" << result.max;
+            if (result.counters)
+            {
+                out << ",\"cycles\":" << result.counters->cycles << ",\"instructions\":" << result.counters->instructions
+                    << ",\"cache_misses\":" << result.counters->cache_misses << ",\"branch_misses\":" << result.counters->branch_misses;
+            }
+            if (result.allocations)
+                out << ",\"allocations\":" << *result.allocations;
+            out << (i + 1 < results.size() ? "},\n" : "}\n");
+        }
+        out << "]\n";
+    }
+
+    inline void WriteCsv(std::ostream& out, const std::vector<Result>& results)
+    {
+        out << "group,name,size,iterations,median_ns,p10_ns,p90_ns,p99_ns,mean_ns,min_ns,max_ns,cycles,instructions,cache_misses,branch_misses,allocations\n";
+        for (const Result& result : results)
+        {
+            out << CsvString(result.group) << ',' << CsvString(result.name) << ',' << result.size << ',' << result.iterations << ',' << result.median << ','
+                << result.p10 << ',' << result.p90 << ',' << result.p99 << ',' << result.mean << ',' << result.min << ',' << result.max;
+            if (result.counters)
+                out << ',' << result.counters->cycles << ',' << result.counters->instructions << ',' << result.counters->cache_misses << ',' << result.counters->branch_misses;
+            else
+                out << ",,,,";
+            out << ',';
+            if (result.allocations)
+                out << *result.allocations;
+            out << '\n';
+        }
+    }
+
+    /// Таблица для терминала
+    inline void WriteTable(std::ostream& out, const Result& result)
+    {
+        out << result.group << " | " << result.name << " [" << result.size << "]: median " << result.median << " ns, p10 " << result.p10
+            << " ns, p90 " << result.p90 << " ns";
+        if (result.counters)
+            out << ", " << result.counters->instructions << " instr, " << result.counters->cycles << " cycles";
+        if (result.allocations)
+            out << ", " << *result.allocations << " allocs";
+        out << std::endl;
+    }
+}
+
+#endif /* Benchmark_h */
@@ -0,0 +1,98 @@
+#ifndef CpuFeatures_h
+#define CpuFeatures_h
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+/*
+ Выбор SIMD-ядра во время выполнения: сборка по умолчанию - только SSE2 (x86-64), а MSVC не определяет __SSSE3__/__AVX2__ вовсе,
+ поэтому ядра с #if defined(__AVX2__) без -march=native никогда не компилируются.
+ CPU_TARGET("avx2") - атрибут функции в GCC/Clang: интринсики набора разрешены только в ней, без -m флагов для всей программы
+ (такую функцию нельзя встроить в вызывающую без этого набора - вызов выбирается один раз на буфер или на объект, а не на байт).
+ MSVC разрешает интринсики любого набора без флагов, атрибут пустой. CPU_DISPATCH - оба условия выполнены (x86-64 или x86).
+ cpu::HasSsse3()/HasSse41()/HasAvx2() - cpuid один раз при первом вызове; если набор включен при компиляции - константа true.
+ */
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define CPU_TARGET(isa) __attribute__((target(isa)))
+#define CPU_DISPATCH 1
+#elif defined(_MSC_VER) && defined(_M_X64)
+#define CPU_TARGET(isa)
+#define CPU_DISPATCH 1
+#else
+#define CPU_TARGET(isa)
+#define CPU_DISPATCH 0
+#endif
+
+namespace cpu
+{
+    struct Features
+    {
+        bool ssse3 = false;
+        bool sse41 = false;
+        bool avx2 = false; // вместе с поддержкой регистров YMM в ОС
+    };
+
+    inline Features Detect() noexcept
+    {
+        Features result;
+#if defined(_MSC_VER) && defined(_M_X64)
+        int info[4];
+        __cpuid(info, 0);
+        const int max_leaf = info[0];
+        if (max_leaf < 1)
+            return result;
+        __cpuid(info, 1);
+        result.ssse3 = info[2] >> 9 & 1;
+        result.sse41 = info[2] >> 19 & 1;
+        const bool avx = (info[2] >> 27 & 1) && (info[2] >> 28 & 1) && (_xgetbv(0) & 6) == 6; // OSXSAVE, AVX, XMM и YMM сохраняются ОС
+        if (avx && max_leaf >= 7)
+        {
+            __cpuidex(info, 7, 0);
+            result.avx2 = info[1] >> 5 & 1;
+        }
+#elif CPU_DISPATCH
+        __builtin_cpu_init();
+        result.ssse3 = __builtin_cpu_supports("ssse3");
+        result.sse41 = __builtin_cpu_supports("sse4.1");
+        result.avx2 = __builtin_cpu_supports("avx2");
+#endif
+        return result;
+    }
+
+    inline const Features& features() noexcept
+    {
+        static const Features result = Detect();
+        return result;
+    }
+
+    inline bool HasSsse3() noexcept
+    {
+#if defined(__SSSE3__)
+        return true;
+#else
+        return features().ssse3;
+#endif
+    }
+
+    inline bool HasSse41() noexcept
+    {
+#if defined(__SSE4_1__)
+        return true;
+#else
+        return features().sse41;
+#endif
+    }
+
+    inline bool HasAvx2() noexcept
+    {
+#if defined(__AVX2__)
+        return true;
+#else
+        return features().avx2;
+#endif
+    }
+}
+
+#endif /* CpuFeatures_h */
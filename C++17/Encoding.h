@@ -0,0 +1,600 @@
+#ifndef Encoding_h
+#define Encoding_h
+
+#include "CpuFeatures.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define ENCODING_SSE2 1
+#endif
+#if defined(__SSSE3__) || CPU_DISPATCH
+#include <tmmintrin.h>
+#define ENCODING_SSSE3 1
+#endif
+
+/*
+ Перекодирование Windows-1251 <-> UTF-8 и проверка UTF-8 целыми буферами (вместо посимвольного преобразования через локаль).
+ Вход - std::string_view, выход - буфер вызывающего (std::span<char>), результат - Result: сколько прочитано/записано и ошибка
+ (read указывает на начало ошибочного символа, все до него уже записано). Для CP1251 -> UTF-8 хватает буфера MaxUtf8Size(size),
+ для UTF-8 -> CP1251 - размера входа.
+ SCALAR - посимвольно через таблицы. Основные функции обрабатывают блоки по 16 байт:
+ - SSE2: блок из одного ASCII копируется целиком (проверка - один movemask)
+ - SSSE3: блок из ASCII и букв А-я (CP1251 0xC0-0xFF = U+0410-U+044F = D0 90..D1 8F в UTF-8) перекодируется без ветвлений:
+   у каждого байта считаются оба байта UTF-8, лишние (ведущие у ASCII) выбрасываются pshufb по таблице масок.
+   Проверка UTF-8 - алгоритм Кайзера-Лемира (три таблицы по старшему/младшему полубайту предыдущего и текущего байта)
+ Блоки с прочими символами (Ё, кавычки «», тире) и хвост - посимвольно, после них снова блоками.
+ SSSE3-версия компилируется всегда (CPU_TARGET) и выбирается во время выполнения по cpuid, если сборка не для SSSE3 (-march=native).
+ */
+
+namespace encoding
+{
+    enum class Error
+    {
+        None,
+        InvalidSequence, // некорректный UTF-8 (в том числе сверхдлинная форма, суррогат, > U+10FFFF)
+        Truncated,       // вход закончился посреди символа UTF-8 - остаток можно дописать к следующей порции
+        Unmappable,      // символа нет в другой кодировке (или байт 0x98, не определенный в CP1251)
+        OutputTooSmall
+    };
+
+    struct Result
+    {
+        Error error = Error::None;
+        size_t read = 0;
+        size_t written = 0;
+
+        explicit operator bool() const noexcept { return error == Error::None; }
+        friend bool operator==(const Result&, const Result&) = default;
+    };
+
+    inline constexpr size_t MaxUtf8Size(size_t cp1251_size) noexcept
+    {
+        return 3 * cp1251_size; // € (0x88), № (0xB9), ™ (0x99) и кавычки - 3 байта, кириллица - 2
+    }
+
+    inline constexpr char32_t no_character = 0xFFFFFFFF;
+
+    /// CP1251 0x80-0xBF -> Unicode, 0xC0-0xFF -> U+0410-U+044F (А-я)
+    inline constexpr std::array<char32_t, 64> cp1251_high =
+    {
+        0x0402, 0x0403, 0x201A, 0x0453, 0x201E, 0x2026, 0x2020, 0x2021, 0x20AC, 0x2030, 0x0409, 0x2039, 0x040A, 0x040C, 0x040B, 0x040F,
+        0x0452, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014, no_character, 0x2122, 0x0459, 0x203A, 0x045A, 0x045C, 0x045B, 0x045F,
+        0x00A0, 0x040E, 0x045E, 0x0408, 0x00A4, 0x0490, 0x00A6, 0x00A7, 0x0401, 0x00A9, 0x0404, 0x00AB, 0x00AC, 0x00AD, 0x00AE, 0x0407,
+        0x00B0, 0x00B1, 0x0406, 0x0456, 0x0491, 0x00B5, 0x00B6, 0x00B7, 0x0451, 0x2116, 0x0454, 0x00BB, 0x0458, 0x0405, 0x0455, 0x0457
+    };
+
+    inline constexpr char32_t ToUnicode(unsigned char c) noexcept
+    {
+        if (c < 0x80)
+            return c;
+        if (c >= 0xC0)
+            return 0x0410 + (c - 0xC0);
+        return cp1251_high[c - 0x80];
+    }
+
+    /// Байт CP1251 по символу, -1 - нет такого
+    inline constexpr int FromUnicode(char32_t code) noexcept
+    {
+        if (code < 0x80)
+            return static_cast<int>(code);
+        if (code >= 0x0410 && code <= 0x044F)
+            return static_cast<int>(code - 0x0410 + 0xC0);
+
+        // 0x80-0xBF: 63 пары (символ, байт), отсортированные по символу
+        constexpr auto table = []()
+        {
+            std::array<std::pair<char32_t, unsigned char>, 63> result {};
+            size_t size = 0;
+            for (size_t i = 0; i < cp1251_high.size(); ++i)
+                if (cp1251_high[i] != no_character)
+                    result[size++] = {cp1251_high[i], static_cast<unsigned char>(0x80 + i)};
+            std::sort(result.begin(), result.end());
+            return result;
+        }();
+        auto it = std::lower_bound(table.begin(), table.end(), code, [](const auto& entry, char32_t value) { return entry.first < value; });
+        return it != table.end() && it->first == code ? it->second : -1;
+    }
+
+    /// Байт CP1251 -> UTF-8: байты в младших разрядах по порядку, длина - в старшем байте (0 - не определен)
+    inline constexpr std::array<uint32_t, 256> cp1251_utf8 = []()
+    {
+        std::array<uint32_t, 256> result {};
+        for (size_t c = 0; c < 256; ++c)
+        {
+            char32_t code = ToUnicode(static_cast<unsigned char>(c));
+            if (code == no_character)
+                result[c] = 0;
+            else if (code < 0x80)
+                result[c] = 1u << 24 | code;
+            else if (code < 0x800)
+                result[c] = 2u << 24 | (0x80 | (code & 0x3F)) << 8 | (0xC0 | code >> 6);
+            else
+                result[c] = 3u << 24 | (0x80 | (code & 0x3F)) << 16 | (0x80 | (code >> 6 & 0x3F)) << 8 | (0xE0 | code >> 12);
+        }
+        return result;
+    }();
+
+    struct Decoded
+    {
+        char32_t code = 0;
+        size_t length = 0;
+        Error error = Error::None;
+    };
+
+    /// Один символ UTF-8 с полной проверкой (диапазоны второго байта - RFC 3629)
+    inline constexpr Decoded DecodeUtf8(const unsigned char* data, size_t size) noexcept
+    {
+        unsigned char lead = data[0];
+        if (lead < 0x80)
+            return {lead, 1};
+        if (lead < 0xC2 || lead > 0xF4)
+            return {0, 0, Error::InvalidSequence}; // продолжение без начала, C0/C1 - сверхдлинные, F5+ - больше U+10FFFF
+
+        size_t length = lead < 0xE0 ? 2 : lead < 0xF0 ? 3 : 4;
+        unsigned char low = lead == 0xE0 ? 0xA0 : lead == 0xF0 ? 0x90 : 0x80;
+        unsigned char high = lead == 0xED ? 0x9F : lead == 0xF4 ? 0x8F : 0xBF;
+        char32_t code = lead & (0x7F >> length);
+        for (size_t i = 1; i < length; ++i)
+        {
+            if (i >= size)
+                return {0, 0, Error::Truncated};
+            unsigned char c = data[i];
+            if (c < (i == 1 ? low : 0x80) || c > (i == 1 ? high : 0xBF))
+                return {0, 0, Error::InvalidSequence};
+            code = code << 6 | (c & 0x3F);
+        }
+        return {code, length};
+    }
+
+    /*
+     Посимвольные версии. result и limit - продолжить с result.read и остановиться на первом символе, начинающемся не раньше limit
+     (через них основные функции обрабатывают блоки, которые не подошли для SIMD).
+     */
+    namespace SCALAR
+    {
+        // read/written - локальные копии: запись char через указатель могла бы изменить поля result, и компилятор перечитывал бы их
+        inline Result Cp1251ToUtf8(std::string_view in, std::span<char> out, Result result = {}, size_t limit = std::string_view::npos)
+        {
+            limit = std::min(limit, in.size());
+            size_t read = result.read, written = result.written;
+            for (; read < limit; ++read)
+            {
+                uint32_t entry = cp1251_utf8[static_cast<unsigned char>(in[read])];
+                size_t length = entry >> 24;
+                if (length == 0 || length > out.size() - written)
+                {
+                    result.error = length == 0 ? Error::Unmappable : Error::OutputTooSmall;
+                    break;
+                }
+                for (size_t i = 0; i < length; ++i)
+                    out[written++] = static_cast<char>(entry >> (8 * i));
+            }
+            result.read = read;
+            result.written = written;
+            return result;
+        }
+
+        inline Result Utf8ToCp1251(std::string_view in, std::span<char> out, Result result = {}, size_t limit = std::string_view::npos)
+        {
+            limit = std::min(limit, in.size());
+            const auto* data = reinterpret_cast<const unsigned char*>(in.data());
+            size_t read = result.read, written = result.written;
+            while (read < limit)
+            {
+                Decoded decoded = DecodeUtf8(data + read, in.size() - read);
+                int c = decoded.error == Error::None ? FromUnicode(decoded.code) : -1;
+                if (c < 0 || written == out.size())
+                {
+                    result.error = decoded.error != Error::None ? decoded.error : c < 0 ? Error::Unmappable : Error::OutputTooSmall;
+                    break;
+                }
+                out[written++] = static_cast<char>(c);
+                read += decoded.length;
+            }
+            result.read = read;
+            result.written = written;
+            return result;
+        }
+
+        /// read - длина корректного начала (позиция ошибки)
+        inline Result ValidateUtf8(std::string_view in, Result result = {}, size_t limit = std::string_view::npos)
+        {
+            limit = std::min(limit, in.size());
+            const auto* data = reinterpret_cast<const unsigned char*>(in.data());
+            while (result.read < limit)
+            {
+                if (data[result.read] < 0x80)
+                {
+                    ++result.read;
+                    continue;
+                }
+                Decoded decoded = DecodeUtf8(data + result.read, in.size() - result.read);
+                if (decoded.error != Error::None)
+                {
+                    result.error = decoded.error;
+                    return result;
+                }
+                result.read += decoded.length;
+            }
+            return result;
+        }
+
+        /// Проверка с начала символа, который может начинаться до position (не дальше 3 байтов назад; после SSE2 position уже на границе)
+        inline Result ValidateFrom(std::string_view in, size_t position)
+        {
+            size_t from = position;
+            for (size_t i = position - std::min<size_t>(position, 3); i < position; ++i)
+                if ((static_cast<unsigned char>(in[i]) & 0xC0) != 0x80)
+                {
+                    from = i;
+                    break;
+                }
+            return SCALAR::ValidateUtf8(in, {.read = from});
+        }
+    }
+
+#if defined(ENCODING_SSSE3)
+    /// Маска из 8 бит -> индексы pshufb: бит k установлен - из пары байтов 2k, 2k + 1 остается только 2k + 1
+    inline constexpr auto expand_shuffle = []()
+    {
+        std::array<std::array<char, 16>, 256> result {};
+        for (size_t mask = 0; mask < 256; ++mask)
+        {
+            size_t size = 0;
+            for (size_t k = 0; k < 8; ++k)
+            {
+                if (!(mask >> k & 1))
+                    result[mask][size++] = static_cast<char>(2 * k);
+                result[mask][size++] = static_cast<char>(2 * k + 1);
+            }
+            while (size < 16)
+                result[mask][size++] = static_cast<char>(0x80);
+        }
+        return result;
+    }();
+
+    /// Маска из 8 бит -> индексы pshufb: байты с установленным битом выбрасываются, остальные сдвигаются к началу
+    inline constexpr auto compact_shuffle = []()
+    {
+        std::array<std::array<char, 16>, 256> result {};
+        for (size_t mask = 0; mask < 256; ++mask)
+        {
+            size_t size = 0;
+            for (size_t k = 0; k < 8; ++k)
+                if (!(mask >> k & 1))
+                    result[mask][size++] = static_cast<char>(k);
+            while (size < 16)
+                result[mask][size++] = static_cast<char>(0x80);
+        }
+        return result;
+    }();
+
+    CPU_TARGET("ssse3") inline __m128i Shuffle(const std::array<char, 16>& indices) noexcept
+    {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(indices.data()));
+    }
+#endif
+
+#if defined(ENCODING_SSE2)
+    /// Блоки из одного ASCII - целиком, остальное посимвольно (без SSSE3 кириллица идет подряд - не проверять каждые 16 байт)
+    namespace SSE2
+    {
+        inline Result Cp1251ToUtf8(std::string_view in, std::span<char> out)
+        {
+            Result result;
+            while (result.read < in.size())
+            {
+                if (in.size() - result.read >= 16 && out.size() - result.written >= 16)
+                {
+                    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in.data() + result.read));
+                    if (_mm_movemask_epi8(block) == 0)
+                    {
+                        _mm_storeu_si128(reinterpret_cast<__m128i*>(out.data() + result.written), block);
+                        result.read += 16;
+                        result.written += 16;
+                        continue;
+                    }
+                }
+                result = SCALAR::Cp1251ToUtf8(in, out, result, result.read + 64);
+                if (result.error != Error::None)
+                    return result;
+            }
+            return result;
+        }
+
+        inline Result Utf8ToCp1251(std::string_view in, std::span<char> out)
+        {
+            Result result;
+            while (result.read < in.size())
+            {
+                if (in.size() - result.read >= 16 && out.size() - result.written >= 16)
+                {
+                    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in.data() + result.read));
+                    if (_mm_movemask_epi8(block) == 0)
+                    {
+                        _mm_storeu_si128(reinterpret_cast<__m128i*>(out.data() + result.written), block);
+                        result.read += 16;
+                        result.written += 16;
+                        continue;
+                    }
+                }
+                result = SCALAR::Utf8ToCp1251(in, out, result, result.read + 64);
+                if (result.error != Error::None)
+                    return result;
+            }
+            return result;
+        }
+
+        inline Result ValidateUtf8(std::string_view in)
+        {
+            size_t position = 0;
+            // ASCII блоками, остальное посимвольно до границы символа за блоком (position всегда на границе символа)
+            while (position + 16 <= in.size())
+            {
+                if (_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in.data() + position))) == 0)
+                {
+                    position += 16;
+                    continue;
+                }
+                Result result = SCALAR::ValidateUtf8(in, {.read = position}, position + 64);
+                if (result.error != Error::None)
+                    return result;
+                position = result.read;
+            }
+            return SCALAR::ValidateFrom(in, position);
+        }
+    }
+#endif
+
+#if defined(ENCODING_SSSE3)
+    /// Блоки из ASCII и А-я - без ветвлений, проверка UTF-8 - по таблицам полубайтов
+    namespace SSSE3
+    {
+        CPU_TARGET("ssse3") inline Result Cp1251ToUtf8(std::string_view in, std::span<char> out)
+        {
+            Result result;
+            while (result.read < in.size())
+            {
+                if (in.size() - result.read >= 16 && out.size() - result.written >= 48)
+                {
+                    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in.data() + result.read));
+                    char* output = out.data() + result.written;
+                    if (_mm_movemask_epi8(block) == 0)
+                    {
+                        _mm_storeu_si128(reinterpret_cast<__m128i*>(output), block);
+                        result.read += 16;
+                        result.written += 16;
+                        continue;
+                    }
+                    // Начало блока до первого символа, кроме ASCII и А-я (как знаковые числа это 0..127 и -64..-1)
+                    const size_t count = std::countr_one(static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpgt_epi8(block, _mm_set1_epi8(-65)))));
+                    if (count)
+                    {
+                        const __m128i ascii = _mm_cmpgt_epi8(block, _mm_set1_epi8(-1));
+                        const __m128i high = _mm_andnot_si128(ascii, _mm_cmpgt_epi8(block, _mm_set1_epi8(-17))); // р-я (0xF0-0xFF) -> D1 80..8F
+                        const __m128i lead = _mm_sub_epi8(_mm_set1_epi8(static_cast<char>(0xD0)), high);
+                        const __m128i shift = _mm_andnot_si128(ascii, _mm_or_si128(_mm_set1_epi8(0x30), _mm_and_si128(high, _mm_set1_epi8(0x40))));
+                        const __m128i trail = _mm_sub_epi8(block, shift);
+                        const unsigned ascii_mask = static_cast<unsigned>(_mm_movemask_epi8(ascii));
+
+                        // Байты первых 8 символов, за ними - следующих 8; из записанного засчитываются только count символов
+                        _mm_storeu_si128(reinterpret_cast<__m128i*>(output), _mm_shuffle_epi8(_mm_unpacklo_epi8(lead, trail), Shuffle(expand_shuffle[ascii_mask & 0xFF])));
+                        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + 16 - std::popcount(ascii_mask & 0xFF)),
+                                         _mm_shuffle_epi8(_mm_unpackhi_epi8(lead, trail), Shuffle(expand_shuffle[ascii_mask >> 8])));
+
+                        result.read += count;
+                        result.written += 2 * count - std::popcount(ascii_mask & ((1u << count) - 1));
+                        if (count == 16)
+                            continue;
+                    }
+                    result = SCALAR::Cp1251ToUtf8(in, out, result, result.read + 1);
+                }
+                else
+                    result = SCALAR::Cp1251ToUtf8(in, out, result, result.read + 64);
+                if (result.error != Error::None)
+                    return result;
+            }
+            return result;
+        }
+
+        CPU_TARGET("ssse3") inline Result Utf8ToCp1251(std::string_view in, std::span<char> out)
+        {
+            Result result;
+            while (result.read < in.size())
+            {
+                if (in.size() - result.read >= 16 && out.size() - result.written >= 16)
+                {
+                    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in.data() + result.read));
+                    char* output = out.data() + result.written;
+                    if (_mm_movemask_epi8(block) == 0)
+                    {
+                        _mm_storeu_si128(reinterpret_cast<__m128i*>(output), block);
+                        result.read += 16;
+                        result.written += 16;
+                        continue;
+                    }
+                    // Только ASCII и пары D0 90..BF (А-п), D1 80..8F (р-я); блок начинается и заканчивается на границе символа
+                    const __m128i d0 = _mm_cmpeq_epi8(block, _mm_set1_epi8(static_cast<char>(0xD0)));
+                    const __m128i d1 = _mm_cmpeq_epi8(block, _mm_set1_epi8(static_cast<char>(0xD1)));
+                    const __m128i lead = _mm_or_si128(d0, d1);
+                    const __m128i continuation = _mm_cmpeq_epi8(_mm_and_si128(block, _mm_set1_epi8(static_cast<char>(0xC0))), _mm_set1_epi8(static_cast<char>(0x80)));
+                    const __m128i after_d0 = _mm_slli_si128(d0, 1);
+                    const __m128i after_d1 = _mm_slli_si128(d1, 1);
+                    const __m128i letter = _mm_and_si128(continuation, _mm_or_si128(
+                        _mm_and_si128(after_d0, _mm_cmpgt_epi8(block, _mm_set1_epi8(-113))),  // >= 0x90
+                        _mm_and_si128(after_d1, _mm_cmplt_epi8(block, _mm_set1_epi8(-112))))); // <= 0x8F
+                    const __m128i complete = _mm_and_si128(lead, _mm_srli_si128(letter, 1)); // у последнего байта блока продолжения нет
+                    const __m128i ascii = _mm_cmpgt_epi8(block, _mm_set1_epi8(-1));
+                    // Начало блока до первого другого символа (оно всегда заканчивается на границе символа)
+                    const size_t count = std::countr_one(static_cast<unsigned>(_mm_movemask_epi8(_mm_or_si128(ascii, _mm_or_si128(complete, letter)))));
+                    if (count)
+                    {
+                        const __m128i shift = _mm_or_si128(_mm_and_si128(after_d0, _mm_set1_epi8(0x30)), _mm_and_si128(after_d1, _mm_set1_epi8(0x70)));
+                        const __m128i value = _mm_add_epi8(block, _mm_and_si128(letter, shift));
+                        const unsigned lead_mask = static_cast<unsigned>(_mm_movemask_epi8(lead));
+
+                        _mm_storel_epi64(reinterpret_cast<__m128i*>(output), _mm_shuffle_epi8(value, Shuffle(compact_shuffle[lead_mask & 0xFF])));
+                        _mm_storel_epi64(reinterpret_cast<__m128i*>(output + 8 - std::popcount(lead_mask & 0xFF)),
+                                         _mm_shuffle_epi8(_mm_srli_si128(value, 8), Shuffle(compact_shuffle[lead_mask >> 8])));
+
+                        result.read += count;
+                        result.written += count - std::popcount(lead_mask & ((1u << count) - 1));
+                        if (count == 16 || (count == 15 && lead_mask >> 15))
+                            continue; // D0/D1 в последнем байте - начало следующего блока
+                    }
+                    result = SCALAR::Utf8ToCp1251(in, out, result, result.read + 1);
+                }
+                else
+                    result = SCALAR::Utf8ToCp1251(in, out, result, result.read + 64);
+                if (result.error != Error::None)
+                    return result;
+            }
+            return result;
+        }
+
+        CPU_TARGET("ssse3") inline Result ValidateUtf8(std::string_view in)
+        {
+            size_t position = 0;
+            // Биты ошибок двух соседних байтов (prev1 - предыдущий, input - текущий): ошибка, если бит есть во всех трех таблицах
+            constexpr char too_short = 1 << 0;      // 11______ 0_______ или 11______ 11______
+            constexpr char too_long = 1 << 1;       // 0_______ 10______
+            constexpr char overlong_3 = 1 << 2;     // 11100000 100_____
+            constexpr char too_large = 1 << 3;      // 11110100 1001____, 11110100 101_____, 11110101+ 10______
+            constexpr char surrogate = 1 << 4;      // 11101101 101_____
+            constexpr char overlong_2 = 1 << 5;     // 1100000_ 10______
+            constexpr char too_large_1000 = 1 << 6; // 11110101+ 1000____
+            constexpr char overlong_4 = 1 << 6;     // 11110000 1000____
+            constexpr char two_continuations = static_cast<char>(1 << 7); // 10______ 10______ (законно для 3-го и 4-го байта)
+            constexpr char carry = too_short | too_long | two_continuations;
+
+            const __m128i byte_1_high = _mm_setr_epi8(
+                too_long, too_long, too_long, too_long, too_long, too_long, too_long, too_long,
+                two_continuations, two_continuations, two_continuations, two_continuations,
+                too_short | overlong_2, too_short, too_short | overlong_3 | surrogate, too_short | too_large | too_large_1000 | overlong_4);
+            const __m128i byte_1_low = _mm_setr_epi8(
+                carry | overlong_3 | overlong_2 | overlong_4, carry | overlong_2, carry, carry,
+                carry | too_large, carry | too_large | too_large_1000, carry | too_large | too_large_1000, carry | too_large | too_large_1000,
+                carry | too_large | too_large_1000, carry | too_large | too_large_1000, carry | too_large | too_large_1000, carry | too_large | too_large_1000,
+                carry | too_large | too_large_1000, carry | too_large | too_large_1000 | surrogate, carry | too_large | too_large_1000, carry | too_large | too_large_1000);
+            const __m128i byte_2_high = _mm_setr_epi8(
+                too_short, too_short, too_short, too_short, too_short, too_short, too_short, too_short,
+                too_long | overlong_2 | two_continuations | overlong_3 | too_large_1000 | overlong_4,
+                too_long | overlong_2 | two_continuations | overlong_3 | too_large,
+                too_long | overlong_2 | two_continuations | surrogate | too_large,
+                too_long | overlong_2 | two_continuations | surrogate | too_large,
+                too_short, too_short, too_short, too_short);
+            const __m128i nibble = _mm_set1_epi8(0x0F);
+            // Незаконченный символ в конце блока: последние 3 байта больше 0xEF, 0xDF, 0xBF
+            const __m128i incomplete_limit = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, static_cast<char>(0xF0 - 1), static_cast<char>(0xE0 - 1), static_cast<char>(0xC0 - 1));
+
+            __m128i previous = _mm_setzero_si128();
+            __m128i previous_incomplete = _mm_setzero_si128();
+            for (; position + 16 <= in.size(); position += 16)
+            {
+                const __m128i input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in.data() + position));
+                __m128i error = previous_incomplete;
+                if (_mm_movemask_epi8(input) != 0)
+                {
+                    const __m128i prev1 = _mm_alignr_epi8(input, previous, 15);
+                    const __m128i special = _mm_and_si128(_mm_and_si128(
+                        _mm_shuffle_epi8(byte_1_high, _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble)),
+                        _mm_shuffle_epi8(byte_1_low, _mm_and_si128(prev1, nibble))),
+                        _mm_shuffle_epi8(byte_2_high, _mm_and_si128(_mm_srli_epi16(input, 4), nibble)));
+                    // 3-й и 4-й байты обязаны быть продолжениями: там two_continuations не ошибка, а его отсутствие - ошибка
+                    const __m128i third = _mm_subs_epu8(_mm_alignr_epi8(input, previous, 14), _mm_set1_epi8(static_cast<char>(0xE0 - 0x80)));
+                    const __m128i fourth = _mm_subs_epu8(_mm_alignr_epi8(input, previous, 13), _mm_set1_epi8(static_cast<char>(0xF0 - 0x80)));
+                    const __m128i must_continue = _mm_and_si128(_mm_or_si128(third, fourth), _mm_set1_epi8(static_cast<char>(0x80)));
+                    error = _mm_xor_si128(must_continue, special);
+                }
+                previous_incomplete = _mm_subs_epu8(input, incomplete_limit);
+                previous = input;
+
+                if (_mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128())) != 0xFFFF)
+                    break; // точную позицию найдет посимвольная проверка
+            }
+            return SCALAR::ValidateFrom(in, position);
+        }
+    }
+#endif
+
+    inline Result Cp1251ToUtf8(std::string_view in, std::span<char> out)
+    {
+#if defined(ENCODING_SSSE3)
+        if (cpu::HasSsse3())
+            return SSSE3::Cp1251ToUtf8(in, out);
+#endif
+#if defined(ENCODING_SSE2)
+        return SSE2::Cp1251ToUtf8(in, out);
+#else
+        return SCALAR::Cp1251ToUtf8(in, out);
+#endif
+    }
+
+    inline Result Utf8ToCp1251(std::string_view in, std::span<char> out)
+    {
+#if defined(ENCODING_SSSE3)
+        if (cpu::HasSsse3())
+            return SSSE3::Utf8ToCp1251(in, out);
+#endif
+#if defined(ENCODING_SSE2)
+        return SSE2::Utf8ToCp1251(in, out);
+#else
+        return SCALAR::Utf8ToCp1251(in, out);
+#endif
+    }
+
+    inline Result ValidateUtf8(std::string_view in)
+    {
+#if defined(ENCODING_SSSE3)
+        if (cpu::HasSsse3())
+            return SSSE3::ValidateUtf8(in);
+#endif
+#if defined(ENCODING_SSE2)
+        return SSE2::ValidateUtf8(in);
+#else
+        return SCALAR::ValidateUtf8(in);
+#endif
+    }
+
+    /// Русский текст: слова, изредка ё, кавычки, тире и номера; ascii_share - доля латиницы
+    inline std::string MakeRussianText(size_t size, double ascii_share = 0.1)
+    {
+        static constexpr std::string_view russian[] =
+        {
+            "съешь", "же", "этих", "мягких", "французских", "булок", "да", "выпей", "чаю", "Широкая", "электрификация", "южных",
+            "губерний", "даст", "мощный", "толчок", "сельского", "хозяйства", "в", "на", "Москва", "и", "что", "строка", "файл"
+        };
+        static constexpr std::string_view rare[] = {"ещё", "подъём", "«строка»", "—", "№5"};
+        static constexpr std::string_view latin[] = {"std::string_view", "C++17", "SIMD", "UTF-8", "CP1251", "2024"};
+
+        std::mt19937 generator(42);
+        std::uniform_real_distribution<double> share(0, 1);
+        std::string text;
+        text.reserve(size + 32);
+        while (text.size() < size)
+        {
+            double kind = share(generator);
+            if (kind < ascii_share)
+                text += latin[generator() % std::size(latin)];
+            else if (kind < ascii_share + 0.03)
+                text += rare[generator() % std::size(rare)];
+            else
+                text += russian[generator() % std::size(russian)];
+            text += generator() % 8 ? ' ' : '\n';
+        }
+        return text;
+    }
+}
+
+#endif /* Encoding_h */
@@ -0,0 +1,358 @@
+#ifndef FlatMap_h
+#define FlatMap_h
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <numeric>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define FLAT_MAP_SSE2 1
+#endif
+
+/*
+ flat_map - ассоциативный контейнер на двух непрерывных массивах: ключи отдельно от значений.
+ В отличие от std::map (красно-черное дерево) узлы не разбросаны по куче, поэтому поиск идет по кэш-линиям подряд, а ключи не перемешаны со значениями.
+ Подходит для read-mostly данных: вставка/удаление - O(n), поиск - O(log(n)).
+ Layout::Sorted - отсортированный массив: бинарный поиск без ветвлений, последние <= 16 ключей сравниваются SIMD (для 32-битных целых ключей).
+ Layout::Eytzinger - ключи лежат в порядке обхода неявного двоичного дерева (как в куче: потомки k - 2k и 2k + 1), поиск без ветвлений с prefetch на 4 уровня вперед.
+                     Порядок обхода итератором не отсортирован.
+ Массовая загрузка: несортированный вектор пар сортируется один раз, при повторе ключа остается первое значение (как в std::map).
+ */
+
+namespace containers
+{
+    enum class Layout
+    {
+        Sorted,
+        Eytzinger
+    };
+
+    template<typename Key, typename Value, typename Compare = std::less<>, Layout layout = Layout::Sorted>
+    class flat_map
+    {
+        template<bool IsConst>
+        class Iterator
+        {
+            using Map = std::conditional_t<IsConst, const flat_map, flat_map>;
+            using Reference = std::conditional_t<IsConst, const Value&, Value&>;
+
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using difference_type = std::ptrdiff_t;
+            using value_type = std::pair<const Key&, Reference>;
+            using reference = value_type;
+
+            Iterator() = default;
+            Iterator(Map* map, size_t index) noexcept : _map(map), _index(index) {}
+
+            value_type operator*() const { return {_map->_keys[_index], _map->_values[_index]}; }
+            Iterator& operator++() noexcept { ++_index; return *this; }
+            Iterator operator++(int) noexcept { auto copy = *this; ++_index; return copy; }
+            bool operator==(const Iterator& other) const noexcept { return _index == other._index; }
+
+            const Key& key() const { return _map->_keys[_index]; }
+            Reference value() const { return _map->_values[_index]; }
+
+        private:
+            Map* _map = nullptr;
+            size_t _index = 0;
+        };
+
+    public:
+        using key_type = Key;
+        using mapped_type = Value;
+        using size_type = size_t;
+        using iterator = Iterator<false>;
+        using const_iterator = Iterator<true>;
+
+        flat_map() = default;
+
+        /// Массовая загрузка из несортированных данных: одна сортировка
+        explicit flat_map(std::vector<std::pair<Key, Value>> items, const Compare& compare = Compare()) : _compare(compare)
+        {
+            assign(std::move(items));
+        }
+
+        flat_map(std::initializer_list<std::pair<Key, Value>> items) : flat_map(std::vector<std::pair<Key, Value>>(items)) {}
+
+        void assign(std::vector<std::pair<Key, Value>> items)
+        {
+            std::stable_sort(items.begin(), items.end(), [&](const auto& lhs, const auto& rhs) { return _compare(lhs.first, rhs.first); });
+            auto last = std::unique(items.begin(), items.end(), [&](const auto& lhs, const auto& rhs) { return !_compare(lhs.first, rhs.first); });
+            items.erase(last, items.end());
+            Build(items);
+        }
+
+        size_t size() const noexcept { return _keys.size(); }
+        bool empty() const noexcept { return _keys.empty(); }
+        void clear() noexcept { _keys.clear(); _values.clear(); }
+        void reserve(size_t capacity) { _keys.reserve(capacity); _values.reserve(capacity); }
+
+        iterator begin() noexcept { return {this, 0}; }
+        iterator end() noexcept { return {this, size()}; }
+        const_iterator begin() const noexcept { return {this, 0}; }
+        const_iterator end() const noexcept { return {this, size()}; }
+
+        /// Непрерывные массивы ключей и значений (в порядке хранения)
+        const std::vector<Key>& keys() const noexcept { return _keys; }
+        const std::vector<Value>& values() const noexcept { return _values; }
+
+        template<typename K>
+        iterator find(const K& key) { return {this, Find(key)}; }
+
+        template<typename K>
+        const_iterator find(const K& key) const { return {this, Find(key)}; }
+
+        template<typename K>
+        bool contains(const K& key) const { return Find(key) != size(); }
+
+        template<typename K>
+        size_t count(const K& key) const { return contains(key); }
+
+        template<typename K>
+        Value& at(const K& key)
+        {
+            if (size_t index = Find(key); index != size())
+                return _values[index];
+            throw std::out_of_range("flat_map::at");
+        }
+
+        template<typename K>
+        const Value& at(const K& key) const
+        {
+            return const_cast<flat_map*>(this)->at(key);
+        }
+
+        Value& operator[](const Key& key)
+        {
+            return insert(key, Value()).first.value();
+        }
+
+        /// Вставка с сохранением порядка: O(n). Если ключ уже есть, значение не меняется
+        template<typename K, typename V>
+        std::pair<iterator, bool> insert(K&& key, V&& value)
+        {
+            if (size_t index = Find(key); index != size())
+                return {{this, index}, false};
+
+            if constexpr (layout == Layout::Sorted)
+            {
+                size_t index = LowerBound(key);
+                // K может быть "легким" ключом (std::string_view для std::string): Key создается явно
+                _keys.insert(_keys.begin() + index, Key(std::forward<K>(key)));
+                _values.insert(_values.begin() + index, Value(std::forward<V>(value)));
+                return {{this, index}, true};
+            }
+            else
+            {
+                auto items = Extract();
+                Key new_key(std::forward<K>(key));
+                auto position = std::lower_bound(items.begin(), items.end(), new_key, [&](const auto& item, const Key& k) { return _compare(item.first, k); });
+                size_t rank = position - items.begin();
+                items.emplace(position, std::move(new_key), std::forward<V>(value));
+                return {{this, Build(items, rank)}, true};
+            }
+        }
+
+        /// Удаление: O(n)
+        template<typename K>
+        size_t erase(const K& key)
+        {
+            size_t index = Find(key);
+            if (index == size())
+                return 0;
+
+            if constexpr (layout == Layout::Sorted)
+            {
+                _keys.erase(_keys.begin() + index);
+                _values.erase(_values.begin() + index);
+            }
+            else
+            {
+                size_t rank = Rank(index);
+                auto items = Extract();
+                items.erase(items.begin() + rank);
+                Build(items);
+            }
+            return 1;
+        }
+
+    private:
+        /// Ключи сравниваются SIMD, если это 32-битные целые и обычное сравнение "<"
+        template<typename K>
+        static constexpr bool UseSimd = std::is_integral_v<Key> && sizeof(Key) == 4 && std::is_same_v<K, Key> &&
+                                        (std::is_same_v<Compare, std::less<>> || std::is_same_v<Compare, std::less<Key>>);
+
+        template<typename K>
+        size_t Find(const K& key) const
+        {
+            size_t index = (layout == Layout::Sorted) ? LowerBound(key) : EytzingerSearch(key);
+            return (index != size() && !_compare(key, _keys[index])) ? index : size();
+        }
+
+        /*
+         Бинарный поиск без ветвлений: вместо if - условное перемещение (cmov).
+         Инвариант: искомая позиция лежит в [base, base + length].
+         */
+        template<typename K>
+        size_t LowerBound(const K& key) const
+        {
+            constexpr size_t block = UseSimd<K> ? 16 : 1;
+            const Key* first = _keys.data();
+            const Key* base = first;
+            size_t length = _keys.size();
+            if (length == 0)
+                return 0;
+
+            while (length > block)
+            {
+                size_t half = length / 2;
+                base = _compare(base[half], key) ? base + half : base;
+                length -= half;
+            }
+
+            if constexpr (UseSimd<K>)
+                return (base - first) + CountLess(base, length, key);
+            else
+                return (base - first) + _compare(*base, key);
+        }
+
+        /// Количество ключей < key среди length (<= 16) отсортированных ключей
+        template<typename K>
+        static size_t CountLess(const Key* keys, size_t length, const K& key)
+        {
+            size_t count = 0;
+            size_t i = 0;
+#if defined(FLAT_MAP_SSE2)
+            // Для беззнаковых ключей сдвигаем диапазон, т.к. SSE2 сравнивает только знаковые числа
+            constexpr uint32_t bias = std::is_signed_v<Key> ? 0 : 0x80000000u;
+            const __m128i needle = _mm_set1_epi32(static_cast<int>(static_cast<uint32_t>(key) ^ bias));
+            const __m128i shift = _mm_set1_epi32(static_cast<int>(bias));
+            for (; i + 4 <= length; i += 4)
+            {
+                __m128i block = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + i)), shift);
+                int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(needle, block)));
+                count += std::popcount(static_cast<unsigned>(mask));
+            }
+#endif
+            for (; i < length; ++i)
+                count += keys[i] < key;
+            return count;
+        }
+
+        /*
+         Поиск по раскладке Эйтцингера (нумерация с 1): переход k -> 2k + (keys[k] < key).
+         После выхода за массив номер найденного узла восстанавливается сбросом младших единиц k и еще одного бита.
+         */
+        template<typename K>
+        size_t EytzingerSearch(const K& key) const
+        {
+            const size_t n = _keys.size();
+            if (n == 0)
+                return 0;
+
+            const Key* keys = _keys.data() - 1; // нумерация с 1
+            size_t k = 1;
+            while (k <= n)
+            {
+#if defined(__GNUC__) || defined(__clang__)
+                // Потомки через 4 уровня (16 узлов) лежат подряд - загружаем их заранее
+                if (16 * k <= n)
+                    __builtin_prefetch(keys + 16 * k);
+#endif
+                k = 2 * k + _compare(keys[k], key);
+            }
+            k >>= std::countr_one(k) + 1;
+            return k == 0 ? n : k - 1;
+        }
+
+        /// Позиция i (в порядке сортировки) -> номер узла дерева Эйтцингера
+        static size_t EytzingerOrder(std::vector<size_t>& order, size_t i, size_t k)
+        {
+            if (k <= order.size())
+            {
+                i = EytzingerOrder(order, i, 2 * k);
+                order[k - 1] = i++;
+                i = EytzingerOrder(order, i, 2 * k + 1);
+            }
+            return i;
+        }
+
+        /// Заполнение из отсортированных уникальных пар. Возвращает позицию хранения пары с номером rank
+        size_t Build(std::vector<std::pair<Key, Value>>& items, size_t rank = 0)
+        {
+            _keys.clear();
+            _values.clear();
+            reserve(items.size());
+            if constexpr (layout == Layout::Sorted)
+            {
+                for (auto& [key, value] : items)
+                {
+                    _keys.push_back(std::move(key));
+                    _values.push_back(std::move(value));
+                }
+                return rank;
+            }
+            else
+            {
+                std::vector<size_t> order(items.size());
+                EytzingerOrder(order, 0, 1);
+                for (size_t index : order)
+                {
+                    _keys.push_back(std::move(items[index].first));
+                    _values.push_back(std::move(items[index].second));
+                }
+                return std::find(order.begin(), order.end(), rank) - order.begin();
+            }
+        }
+
+        /// Номер в порядке сортировки для позиции хранения index
+        size_t Rank(size_t index) const
+        {
+            if constexpr (layout == Layout::Sorted)
+            {
+                return index;
+            }
+            else
+            {
+                std::vector<size_t> order(size());
+                EytzingerOrder(order, 0, 1);
+                return order[index];
+            }
+        }
+
+        /// Пары в отсортированном порядке (для перестроения раскладки Эйтцингера)
+        std::vector<std::pair<Key, Value>> Extract()
+        {
+            std::vector<size_t> storage(size());
+            std::iota(storage.begin(), storage.end(), 0);
+            if constexpr (layout == Layout::Eytzinger)
+            {
+                std::vector<size_t> order(size());
+                EytzingerOrder(order, 0, 1);
+                for (size_t i = 0; i < size(); ++i)
+                    storage[order[i]] = i;
+            }
+
+            std::vector<std::pair<Key, Value>> items;
+            items.reserve(size());
+            for (size_t index : storage)
+                items.emplace_back(std::move(_keys[index]), std::move(_values[index]));
+            clear();
+            return items;
+        }
+
+        std::vector<Key> _keys;
+        std::vector<Value> _values;
+        [[no_unique_address]] Compare _compare;
+    };
+}
+
+#endif /* FlatMap_h */
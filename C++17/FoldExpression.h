@@ -1,6 +1,10 @@
 #ifndef FoldExpression_h
 #define FoldExpression_h
 
+#include "Format.h"
+#include "SmallVector.h"
+
+#include <cmath>
 #include <iostream>
 #include <vector>
 
@@ -83,6 +87,14 @@ namespace fold_expression
         (v.push_back(std::forward<Args>(args)), ...);
     }
 
+    /// small_vector: если аргументов не больше N, память в куче не выделяется
+    template<typename T, size_t N, typename... Args>
+    void Push_To_Vector(containers::small_vector<T, N>& v, Args&&... args)
+    {
+        v.reserve(v.size() + sizeof...(args));
+        (v.emplace_back(std::forward<Args>(args)), ...);
+    }
+
     template<typename ...Args>
     inline constexpr int CountArgs(Args&& ...args)
     {
@@ -130,6 +142,44 @@ namespace fold_expression
         ((std::cout << args << ", "), ...);
         std::cout << std::endl;
     }
+
+    // C++20: та же строка "arg1, arg2, ..., \n", но формат собирается на этапе компиляции, числа - через std::to_chars (Format.h)
+    template <typename ...TArgs>
+    inline void PrintFormat(const TArgs&... args)
+    {
+        format::Print<format::joined<sizeof...(args), ", ", ", \n">>(args...);
+    }
+
+    /*
+     До C++17: рекурсивное инстанциирование - для пачки из N аргументов создается N функций (Sum<T1..TN>, Sum<T2..TN>, ..., stub-функция Sum<TN>).
+     Глубина рекурсии ограничена -ftemplate-depth (в GCC по умолчанию 900). Для сравнения времени компиляции с fold expression: compile_benchmark.cpp
+     */
+    namespace RECURSIVE
+    {
+        /// stub-функция (заглушка): конец рекурсии
+        template<typename T>
+        inline constexpr auto Sum(T arg)
+        {
+            return arg;
+        }
+
+        template<typename T, typename... Args>
+        inline constexpr auto Sum(T first, Args... args)
+        {
+            return first + Sum(args...);
+        }
+
+        inline constexpr int CountArgs()
+        {
+            return 0;
+        }
+
+        template<typename T, typename ...Args>
+        inline constexpr int CountArgs(T&&, Args&& ...args)
+        {
+            return 1 + CountArgs(std::forward<Args>(args)...);
+        }
+    }
 }
 
 #endif /* FoldExpression_h */
@@ -0,0 +1,261 @@
+#ifndef Format_h
+#define Format_h
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <concepts>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+/*
+ Форматирование со строкой формата, разобранной на этапе компиляции: format::Print<"{} = {}\n">(name, value).
+ Строка формата - параметр шаблона (класс String, C++20), поэтому разбор выполняется в constexpr: литералы между {} складываются
+ в статический массив, число {} сверяется с sizeof...(args) через static_assert. Для каждой строки формата генерируется своя функция:
+ литерал (memcpy известной длины) -> аргумент -> литерал -> ..., без разбора формата и без счетчика аргументов во время выполнения.
+ Значения пишутся std::to_chars в буфер на стеке (Writer), без виртуальных вызовов и локали iostream. Вещественные числа - кратчайшее
+ точное представление (как std::format, а не precision 6 у std::cout).
+ Поддерживается только {} ({{ и }} - экранированные скобки), спецификаторы вида {:x} - ошибка компиляции.
+ */
+
+namespace format
+{
+    /// Строковый литерал как параметр шаблона
+    template<size_t N>
+    struct String
+    {
+        char data[N] {};
+
+        constexpr String() = default;
+        constexpr String(const char (&text)[N]) { std::copy_n(text, N, data); }
+
+        constexpr size_t size() const noexcept { return N - 1; }
+        constexpr std::string_view view() const noexcept { return {data, N - 1}; }
+    };
+
+    struct Parsed
+    {
+        size_t arguments = 0; // число {}
+        size_t length = 0;    // длина всех литералов без экранирования
+        bool valid = true;
+    };
+
+    constexpr Parsed Parse(std::string_view format)
+    {
+        Parsed result;
+        for (size_t i = 0; i < format.size(); ++i)
+        {
+            char c = format[i];
+            if (c == '{' && i + 1 < format.size() && format[i + 1] == '}')
+            {
+                ++result.arguments;
+                ++i;
+            }
+            else if ((c == '{' || c == '}') && i + 1 < format.size() && format[i + 1] == c)
+            {
+                ++result.length;
+                ++i;
+            }
+            else if (c == '{' || c == '}')
+                result.valid = false;
+            else
+                ++result.length;
+        }
+        return result;
+    }
+
+    /// Разобранная строка формата: литерал I - до I-го {}, последний литерал - после последнего {}
+    template<String FormatString>
+    struct Compiled
+    {
+        static constexpr Parsed parsed = Parse(FormatString.view());
+        static_assert(parsed.valid, "format: непарная фигурная скобка или спецификатор формата (поддерживается только {})");
+
+        static constexpr size_t arguments = parsed.arguments;
+
+        struct Table
+        {
+            std::array<char, parsed.length + 1> text {};
+            std::array<size_t, parsed.arguments + 2> bounds {}; // литерал I: [bounds[I], bounds[I + 1])
+        };
+
+        static constexpr Table table = []()
+        {
+            Table result;
+            std::string_view format = FormatString.view();
+            size_t length = 0, literal = 0;
+            for (size_t i = 0; i < format.size(); ++i)
+            {
+                if (format[i] == '{' && format[i + 1] == '}')
+                {
+                    result.bounds[++literal] = length;
+                    ++i;
+                    continue;
+                }
+                result.text[length++] = format[i];
+                if (format[i] == '{' || format[i] == '}')
+                    ++i; // {{ или }}
+            }
+            result.bounds[++literal] = length;
+            return result;
+        }();
+
+        static constexpr std::string_view Literal(size_t index) noexcept
+        {
+            return {table.text.data() + table.bounds[index], table.bounds[index + 1] - table.bounds[index]};
+        }
+    };
+
+    /// Строка формата из N {} через Separator с End в конце: joined<3, ", ", "\n"> == "{}, {}, {}\n" (скобки в Separator/End не экранируются)
+    template<size_t N, String Separator, String End>
+    inline constexpr auto joined = []()
+    {
+        String<N * 2 + (N ? N - 1 : 0) * Separator.size() + End.size() + 1> result;
+        size_t length = 0;
+        auto append = [&](std::string_view text)
+        {
+            for (char c : text)
+                result.data[length++] = c;
+        };
+        for (size_t i = 0; i < N; ++i)
+        {
+            if (i)
+                append(Separator.view());
+            append("{}");
+        }
+        append(End.view());
+        return result;
+    }();
+
+    template<typename T>
+    concept string_like = std::is_convertible_v<const T&, std::string_view>;
+
+    template<typename T>
+    concept formattable = std::is_arithmetic_v<T> || string_like<T>;
+
+    /// Буфер на стеке: литералы и числа дописываются в него, при заполнении содержимое отдается в sink(std::string_view)
+    template<typename TSink, size_t Capacity = 256>
+    class Writer
+    {
+        static_assert(Capacity >= 64, "format: в буфер должно помещаться любое число");
+
+    public:
+        explicit Writer(TSink sink) : _sink(std::move(sink)) {}
+        ~Writer() { Flush(); }
+
+        Writer(const Writer&) = delete;
+        Writer& operator=(const Writer&) = delete;
+
+        void Flush()
+        {
+            if (_size)
+                _sink(std::string_view(_buffer, _size));
+            _size = 0;
+        }
+
+        void Append(std::string_view text)
+        {
+            if (text.size() > Capacity - _size)
+            {
+                Flush();
+                if (text.size() > Capacity)
+                {
+                    _sink(text); // длинная строка - мимо буфера
+                    return;
+                }
+            }
+            std::memcpy(_buffer + _size, text.data(), text.size());
+            _size += text.size();
+        }
+
+        template<formattable T>
+        void Append(const T& value)
+        {
+            if constexpr (std::is_same_v<T, bool>)
+                Append(value ? std::string_view("true") : std::string_view("false"));
+            else if constexpr (std::is_same_v<T, char>)
+            {
+                Reserve(1);
+                _buffer[_size++] = value;
+            }
+            else if constexpr (std::is_arithmetic_v<T>)
+            {
+                // целое: знак + digits10 + 1 цифр; вещественное в кратчайшей форме (double - до 24 символов, long double - больше)
+                constexpr size_t max_size = std::is_integral_v<T> ? std::numeric_limits<T>::digits10 + 3 : 64;
+                Reserve(max_size);
+                _size = static_cast<size_t>(std::to_chars(_buffer + _size, _buffer + Capacity, value).ptr - _buffer);
+            }
+            else
+                Append(std::string_view(value));
+        }
+
+    private:
+        void Reserve(size_t size)
+        {
+            if (size > Capacity - _size)
+                Flush();
+        }
+
+        TSink _sink;
+        size_t _size = 0;
+        char _buffer[Capacity];
+    };
+
+    template<String FormatString, typename TWriter, typename... Args>
+    void WriteTo(TWriter& writer, const Args&... args)
+    {
+        using Compiled = format::Compiled<FormatString>;
+        static_assert(Compiled::arguments == sizeof...(Args), "format: число {} не совпадает с числом аргументов");
+
+        if constexpr (Compiled::arguments == sizeof...(Args))
+        {
+            auto literal = [&]<size_t I>(std::integral_constant<size_t, I>)
+            {
+                if constexpr (!Compiled::Literal(I).empty())
+                    writer.Append(Compiled::Literal(I));
+            };
+            [&]<size_t... I>(std::index_sequence<I...>)
+            {
+                ((literal(std::integral_constant<size_t, I>()), writer.Append(args)), ...);
+            }(std::index_sequence_for<Args...>());
+            literal(std::integral_constant<size_t, sizeof...(Args)>());
+        }
+    }
+
+    /// Дописать в конец out
+    template<String FormatString, formattable... Args>
+    void FormatTo(std::string& out, const Args&... args)
+    {
+        Writer writer([&out](std::string_view text) { out.append(text); });
+        WriteTo<FormatString>(writer, args...);
+    }
+
+    template<String FormatString, formattable... Args>
+    [[nodiscard]] std::string Format(const Args&... args)
+    {
+        std::string result;
+        FormatTo<FormatString>(result, args...);
+        return result;
+    }
+
+    /// Одна запись fwrite на вызов (если результат помещается в буфер)
+    template<String FormatString, formattable... Args>
+    void Print(std::FILE* file, const Args&... args)
+    {
+        Writer writer([file](std::string_view text) { std::fwrite(text.data(), 1, text.size(), file); });
+        WriteTo<FormatString>(writer, args...);
+    }
+
+    template<String FormatString, formattable... Args>
+    void Print(const Args&... args)
+    {
+        Print<FormatString>(stdout, args...);
+    }
+}
+
+#endif /* Format_h */
@@ -0,0 +1,500 @@
+#ifndef GroupBy_h
+#define GroupBy_h
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <random>
+#include <ranges>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/*
+ Группировка с агрегатами: "число людей и средний возраст по Location::country" без std::map<std::string, ...>.
+ - Хэш-таблица с открытой адресацией (линейное пробирование) по std::string_view: строка не выделяется на каждую строку входа,
+   ключ копируется в арену один раз - при появлении новой группы. В ячейке хранится хэш: сравнение строк - только при совпадении хэша.
+ - Агрегаты собираются на этапе компиляции: GroupBy<key, Count, Sum<&Person::age>, Average<&Person::age>>, состояние группы -
+   std::tuple состояний агрегатов, обновление и слияние - fold expression по всем агрегатам (как Sum/Average в FoldExpression.h).
+ - Пакет строк делится между потоками, у каждого потока своя таблица (без блокировок), в конце таблицы сливаются.
+ - Если групп в таблице потока больше Options::max_groups, таблица сбрасывается на диск в partitions файлов по старшим битам хэша.
+   В конце каждый раздел читается и сливается отдельно: в памяти одновременно только группы одного раздела.
+ Результат - обратный вызов callback(key, results...) для каждой группы, порядок групп не определен, key действителен только во время вызова.
+ */
+
+namespace group_by
+{
+    /// Число строк в группе
+    struct Count
+    {
+        struct State
+        {
+            uint64_t count = 0;
+        };
+
+        template<typename TRow>
+        static void Add(State& state, const TRow&) noexcept { ++state.count; }
+        static void Merge(State& state, const State& other) noexcept { state.count += other.count; }
+        static uint64_t Result(const State& state) noexcept { return state.count; }
+    };
+
+    /// Сумма поля Field (указатель на член или лямбда без захвата) в типе T
+    template<auto Field, typename T = double>
+    struct Sum
+    {
+        struct State
+        {
+            T sum = 0;
+        };
+
+        template<typename TRow>
+        static void Add(State& state, const TRow& row) noexcept { state.sum += static_cast<T>(std::invoke(Field, row)); }
+        static void Merge(State& state, const State& other) noexcept { state.sum += other.sum; }
+        static T Result(const State& state) noexcept { return state.sum; }
+    };
+
+    template<auto Field>
+    struct Average
+    {
+        struct State
+        {
+            double sum = 0;
+            uint64_t count = 0;
+        };
+
+        template<typename TRow>
+        static void Add(State& state, const TRow& row) noexcept
+        {
+            state.sum += static_cast<double>(std::invoke(Field, row));
+            ++state.count;
+        }
+        static void Merge(State& state, const State& other) noexcept
+        {
+            state.sum += other.sum;
+            state.count += other.count;
+        }
+        static double Result(const State& state) noexcept { return state.count ? state.sum / static_cast<double>(state.count) : 0; }
+    };
+
+    template<auto Field, typename T = double>
+    struct Min
+    {
+        struct State
+        {
+            T value = std::numeric_limits<T>::max();
+        };
+
+        template<typename TRow>
+        static void Add(State& state, const TRow& row) noexcept { state.value = std::min(state.value, static_cast<T>(std::invoke(Field, row))); }
+        static void Merge(State& state, const State& other) noexcept { state.value = std::min(state.value, other.value); }
+        static T Result(const State& state) noexcept { return state.value; }
+    };
+
+    template<auto Field, typename T = double>
+    struct Max
+    {
+        struct State
+        {
+            T value = std::numeric_limits<T>::lowest();
+        };
+
+        template<typename TRow>
+        static void Add(State& state, const TRow& row) noexcept { state.value = std::max(state.value, static_cast<T>(std::invoke(Field, row))); }
+        static void Merge(State& state, const State& other) noexcept { state.value = std::max(state.value, other.value); }
+        static T Result(const State& state) noexcept { return state.value; }
+    };
+
+    /// Набор агрегатов: каждая операция - свертка по всем агрегатам
+    template<typename... TAggregates>
+    struct Aggregates
+    {
+        using State = std::tuple<typename TAggregates::State...>;
+        static_assert((std::is_trivially_copyable_v<typename TAggregates::State> && ...), "group_by: состояние агрегата сбрасывается на диск побайтно");
+
+        template<typename TRow>
+        static void Add(State& state, const TRow& row) noexcept
+        {
+            std::apply([&row](auto&... states) { (TAggregates::Add(states, row), ...); }, state);
+        }
+
+        static void Merge(State& state, const State& other) noexcept
+        {
+            [&]<size_t... I>(std::index_sequence<I...>)
+            {
+                (TAggregates::Merge(std::get<I>(state), std::get<I>(other)), ...);
+            }(std::index_sequence_for<TAggregates...>());
+        }
+
+        static auto Results(const State& state) noexcept
+        {
+            return std::apply([](const auto&... states) { return std::tuple(TAggregates::Result(states)...); }, state);
+        }
+
+        static constexpr size_t size = (sizeof(typename TAggregates::State) + ... + 0);
+
+        static void Write(std::ostream& out, const State& state)
+        {
+            std::apply([&out](const auto&... states) { (out.write(reinterpret_cast<const char*>(&states), sizeof(states)), ...); }, state);
+        }
+
+        static void Read(std::istream& in, State& state)
+        {
+            std::apply([&in](auto&... states) { (in.read(reinterpret_cast<char*>(&states), sizeof(states)), ...); }, state);
+        }
+    };
+
+    /// Строки ключей групп: блоки по 64 КБ, одно выделение на много ключей
+    class Arena
+    {
+    public:
+        std::string_view Store(std::string_view text)
+        {
+            if (text.empty())
+                return {};
+            if (text.size() > _left)
+            {
+                const size_t size = std::max(block_size, text.size());
+                _blocks.push_back(std::make_unique_for_overwrite<char[]>(size));
+                _next = _blocks.back().get();
+                _left = size;
+            }
+            std::memcpy(_next, text.data(), text.size());
+            std::string_view result(_next, text.size());
+            _next += text.size();
+            _left -= text.size();
+            return result;
+        }
+
+        void Clear() noexcept
+        {
+            _blocks.clear();
+            _next = nullptr;
+            _left = 0;
+        }
+
+    private:
+        static constexpr size_t block_size = 64 * 1024;
+
+        std::vector<std::unique_ptr<char[]>> _blocks;
+        char* _next = nullptr;
+        size_t _left = 0;
+    };
+
+    /// Хэш ключа: старший бит всегда 1, 0 - признак пустой ячейки
+    inline uint64_t Hash(std::string_view key) noexcept
+    {
+        return static_cast<uint64_t>(std::hash<std::string_view>()(key)) | (uint64_t(1) << 63);
+    }
+
+    /// Открытая адресация с линейным пробированием, заполнение не больше 3/4
+    template<typename TState>
+    class HashTable
+    {
+    public:
+        struct Slot
+        {
+            uint64_t hash = 0;
+            std::string_view key;
+            TState state {};
+        };
+
+        explicit HashTable(size_t capacity = 1024) : _slots(std::bit_ceil(std::max<size_t>(capacity, 16))), _mask(_slots.size() - 1) {}
+
+        /// Состояние группы key; новая группа - ключ копируется в арену таблицы
+        TState& Find(std::string_view key, uint64_t hash)
+        {
+            for (size_t index = hash & _mask;; index = (index + 1) & _mask)
+            {
+                Slot& slot = _slots[index];
+                if (slot.hash == hash && slot.key == key)
+                    return slot.state;
+                if (slot.hash == 0)
+                {
+                    if ((_size + 1) * 4 > _slots.size() * 3)
+                    {
+                        Grow();
+                        return Find(key, hash);
+                    }
+                    ++_size;
+                    slot.hash = hash;
+                    slot.key = _arena.Store(key);
+                    return slot.state;
+                }
+            }
+        }
+
+        size_t size() const noexcept { return _size; }
+
+        /// function(const Slot&) для каждой группы
+        template<typename TFunction>
+        void ForEach(TFunction&& function) const
+        {
+            for (const Slot& slot : _slots)
+                if (slot.hash)
+                    function(slot);
+        }
+
+        void Clear()
+        {
+            std::fill(_slots.begin(), _slots.end(), Slot());
+            _size = 0;
+            _arena.Clear();
+        }
+
+    private:
+        void Grow()
+        {
+            std::vector<Slot> slots(_slots.size() * 2);
+            _mask = slots.size() - 1;
+            for (Slot& slot : _slots)
+                if (slot.hash)
+                {
+                    size_t index = slot.hash & _mask;
+                    while (slots[index].hash)
+                        index = (index + 1) & _mask;
+                    slots[index] = slot; // ключ остается в той же арене
+                }
+            _slots = std::move(slots);
+        }
+
+        std::vector<Slot> _slots;
+        size_t _mask;
+        size_t _size = 0;
+        Arena _arena;
+    };
+
+    struct Options
+    {
+        size_t threads = std::thread::hardware_concurrency();
+        size_t max_groups = 1 << 20;   // групп в таблице одного потока, больше - сброс на диск
+        size_t partitions = 64;        // файлов на поток при сбросе (степень двойки)
+        std::filesystem::path directory = std::filesystem::temp_directory_path(); // каталог файлов сброса
+    };
+
+    struct Stats
+    {
+        uint64_t rows = 0;
+        uint64_t groups = 0;
+        uint64_t spilled_groups = 0; // записей групп, сброшенных на диск (одна группа может быть сброшена несколькими потоками)
+        uint64_t spilled_bytes = 0;
+    };
+
+    /*
+     Key - ключ группы: указатель на член или лямбда без захвата, возвращающие строку (std::string_view, const std::string&).
+     Add(rows) - пакет строк (можно вызывать много раз, строки пакета после вызова не нужны), Finish(callback) - результаты.
+     */
+    template<auto Key, typename... TAggregates>
+    class GroupBy
+    {
+    public:
+        using Aggregate = Aggregates<TAggregates...>;
+        using State = typename Aggregate::State;
+
+        explicit GroupBy(Options options = {}) : _options(std::move(options))
+        {
+            if (_options.threads == 0)
+                _options.threads = 1;
+            if (_options.max_groups == 0 || !std::has_single_bit(_options.partitions))
+                throw std::invalid_argument("group_by: max_groups > 0, partitions - степень двойки");
+            _workers.resize(_options.threads);
+        }
+
+        ~GroupBy()
+        {
+            RemoveFiles();
+        }
+
+        GroupBy(const GroupBy&) = delete;
+        GroupBy& operator=(const GroupBy&) = delete;
+
+        template<std::ranges::random_access_range TRows>
+        void Add(const TRows& rows)
+        {
+            const size_t size = std::ranges::size(rows);
+            const size_t threads = std::clamp<size_t>(size / parallel_threshold, 1, _workers.size());
+            Parallel(threads, [&](size_t thread)
+            {
+                Worker& worker = _workers[thread];
+                auto begin = std::ranges::begin(rows);
+                for (size_t i = size * thread / threads, end = size * (thread + 1) / threads; i < end; ++i)
+                {
+                    const auto& row = begin[static_cast<std::ptrdiff_t>(i)];
+                    const std::string_view key = std::invoke(Key, row);
+                    Aggregate::Add(worker.table.Find(key, Hash(key)), row);
+                    if (worker.table.size() >= _options.max_groups) [[unlikely]]
+                        Spill(thread);
+                }
+            });
+            _stats.rows += size;
+        }
+
+        /// callback(std::string_view key, results...) для каждой группы; после вызова объект пуст и готов к новым строкам
+        template<typename TCallback>
+        Stats Finish(TCallback&& callback)
+        {
+            auto emit = [&](const auto& slot)
+            {
+                std::apply([&](const auto&... results) { callback(slot.key, results...); }, Aggregate::Results(slot.state));
+                ++_stats.groups;
+            };
+
+            if (!_spilled)
+            {
+                // слияние таблиц потоков в первую
+                HashTable<State>& result = _workers[0].table;
+                for (size_t thread = 1; thread < _workers.size(); ++thread)
+                {
+                    _workers[thread].table.ForEach([&](const auto& slot) { Aggregate::Merge(result.Find(slot.key, slot.hash), slot.state); });
+                    _workers[thread].table.Clear();
+                }
+                result.ForEach(emit);
+                result.Clear();
+            }
+            else
+            {
+                for (size_t thread = 0; thread < _workers.size(); ++thread)
+                    Spill(thread);
+                for (Worker& worker : _workers)
+                    worker.files.clear(); // закрыть файлы для чтения
+
+                HashTable<State> partition;
+                for (size_t index = 0; index < _options.partitions; ++index)
+                {
+                    for (size_t thread = 0; thread < _workers.size(); ++thread)
+                    {
+                        std::ifstream in(Path(thread, index), std::ios::binary);
+                        std::string key;
+                        uint64_t hash;
+                        uint32_t key_size;
+                        State state;
+                        while (in.read(reinterpret_cast<char*>(&hash), sizeof(hash)) && in.read(reinterpret_cast<char*>(&key_size), sizeof(key_size)))
+                        {
+                            key.resize(key_size);
+                            in.read(key.data(), key_size);
+                            Aggregate::Read(in, state);
+                            if (!in)
+                                throw std::runtime_error("group_by: файл сброса поврежден: " + Path(thread, index).string());
+                            Aggregate::Merge(partition.Find(key, hash), state);
+                        }
+                    }
+                    partition.ForEach(emit);
+                    partition.Clear();
+                }
+                RemoveFiles();
+                _spilled = false;
+            }
+
+            return std::exchange(_stats, Stats());
+        }
+
+    private:
+        /// Меньше строк на поток - запуск потока дороже работы
+        static constexpr size_t parallel_threshold = 16 * 1024;
+
+        struct Worker
+        {
+            HashTable<State> table;
+            std::vector<std::ofstream> files; // раздел -> файл, открываются при первом сбросе
+        };
+
+        template<typename TFunction>
+        static void Parallel(size_t threads, TFunction&& function)
+        {
+            std::vector<std::exception_ptr> errors(threads);
+            {
+                std::vector<std::jthread> workers;
+                for (size_t thread = 1; thread < threads; ++thread)
+                    workers.emplace_back([&, thread]()
+                    {
+                        try { function(thread); }
+                        catch (...) { errors[thread] = std::current_exception(); }
+                    });
+                try { function(size_t(0)); }
+                catch (...) { errors[0] = std::current_exception(); }
+            }
+            for (const std::exception_ptr& error : errors)
+                if (error)
+                    std::rethrow_exception(error);
+        }
+
+        std::filesystem::path Path(size_t thread, size_t partition) const
+        {
+            return _options.directory / ("group_by_" + std::to_string(_id) + "_" + std::to_string(thread) + "_" + std::to_string(partition) + ".bin");
+        }
+
+        /// Таблица потока - в файлы разделов по старшим битам хэша (младшие - индекс в таблице)
+        void Spill(size_t thread)
+        {
+            Worker& worker = _workers[thread];
+            if (worker.files.empty())
+            {
+                worker.files.resize(_options.partitions);
+                for (size_t index = 0; index < _options.partitions; ++index)
+                {
+                    worker.files[index].open(Path(thread, index), std::ios::binary | std::ios::trunc);
+                    if (!worker.files[index])
+                        throw std::runtime_error("group_by: не удалось создать файл " + Path(thread, index).string());
+                }
+                _spilled.store(true, std::memory_order_relaxed); // Spill вызывается из потоков Add, читается после join
+            }
+
+            const int shift = 63 - std::countr_zero(_options.partitions); // бит 63 всегда 1
+            uint64_t groups = 0, bytes = 0;
+            worker.table.ForEach([&](const auto& slot)
+            {
+                std::ofstream& out = worker.files[(slot.hash >> shift) & (_options.partitions - 1)];
+                const auto key_size = static_cast<uint32_t>(slot.key.size());
+                out.write(reinterpret_cast<const char*>(&slot.hash), sizeof(slot.hash));
+                out.write(reinterpret_cast<const char*>(&key_size), sizeof(key_size));
+                out.write(slot.key.data(), key_size);
+                Aggregate::Write(out, slot.state);
+                ++groups;
+                bytes += sizeof(slot.hash) + sizeof(key_size) + key_size + Aggregate::size;
+            });
+            for (const std::ofstream& out : worker.files)
+                if (!out)
+                    throw std::runtime_error("group_by: ошибка записи в " + _options.directory.string());
+            worker.table.Clear();
+
+            std::atomic_ref(_stats.spilled_groups).fetch_add(groups, std::memory_order_relaxed);
+            std::atomic_ref(_stats.spilled_bytes).fetch_add(bytes, std::memory_order_relaxed);
+        }
+
+        void RemoveFiles() noexcept
+        {
+            for (size_t thread = 0; thread < _workers.size(); ++thread)
+            {
+                if (_workers[thread].files.empty() && !_spilled)
+                    continue;
+                _workers[thread].files.clear();
+                for (size_t index = 0; index < _options.partitions; ++index)
+                {
+                    std::error_code error;
+                    std::filesystem::remove(Path(thread, index), error);
+                }
+            }
+        }
+
+        Options _options;
+        const uint64_t _id = std::random_device()() ^ (static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count()) << 16); // имена файлов сброса
+        std::vector<Worker> _workers;
+        Stats _stats;
+        std::atomic<bool> _spilled = false;
+    };
+}
+
+#endif /* GroupBy_h */
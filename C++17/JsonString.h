@@ -0,0 +1,60 @@
+#ifndef JsonString_h
+#define JsonString_h
+
+#include <ostream>
+#include <string>
+#include <string_view>
+
+/*
+ Строка JSON без кавычек по краям: кавычка и обратная косая черта экранируются \" и \\, управляющие символы (< 0x20) - \u00XX.
+ Escape(text, append) передает результат кусками в append(std::string_view) и сам память не выделяет - используется и в AllocationProfiler,
+ который пишет в буфер на стеке внутри подмененного operator new. Символы без экранирования передаются одним куском.
+ */
+
+namespace json
+{
+    template<typename TAppend>
+    void Escape(std::string_view text, TAppend&& append)
+    {
+        size_t first = 0;
+        for (size_t i = 0; i < text.size(); ++i)
+        {
+            const auto c = static_cast<unsigned char>(text[i]);
+            if (c != '"' && c != '\\' && c >= 0x20)
+                continue;
+
+            append(text.substr(first, i - first));
+            first = i + 1;
+            if (c == '"' || c == '\\')
+            {
+                const char escaped[] = {'\\', static_cast<char>(c)};
+                append(std::string_view(escaped, sizeof(escaped)));
+            }
+            else
+            {
+                constexpr char digits[] = "0123456789abcdef";
+                const char escaped[] = {'\\', 'u', '0', '0', digits[c >> 4], digits[c & 0xf]};
+                append(std::string_view(escaped, sizeof(escaped)));
+            }
+        }
+        append(text.substr(first));
+    }
+
+    /// Строка JSON в кавычках в поток
+    inline void WriteString(std::ostream& out, std::string_view text)
+    {
+        out << '"';
+        Escape(text, [&](std::string_view part) { out << part; });
+        out << '"';
+    }
+
+    /// Строка JSON в кавычках
+    inline std::string String(std::string_view text)
+    {
+        std::string result = "\"";
+        Escape(text, [&](std::string_view part) { result += part; });
+        return result += '"';
+    }
+}
+
+#endif /* JsonString_h */
@@ -0,0 +1,303 @@
+#ifndef LookupCache_h
+#define LookupCache_h
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/*
+ Кэш мемоизированных поисков, возвращающих std::optional<T>, ограниченного размера.
+ Вытеснение CLOCK (приближение LRU): у каждой ячейки бит обращения. При попадании бит ставится, при вставке в полный кэш стрелка идет по кругу,
+ сбрасывая биты, и вытесняет первую ячейку со сброшенным битом. В отличие от LRU попадание не перестраивает список - только запись одного бита.
+ Поиск по std::string_view без создания std::string (гетерогенный поиск C++20: is_transparent у хэша и сравнения).
+ ShardedClockCache - потокобезопасный вариант: ключ по хэшу попадает в один из шардов со своим мьютексом.
+ get_or_compute(key, function) вызывает function один раз на промах: остальные потоки, промахнувшиеся по тому же ключу, ждут результат (std::shared_future).
+ */
+
+namespace lookup_cache
+{
+    struct StringHash
+    {
+        using is_transparent = void;
+
+        size_t operator()(std::string_view key) const noexcept { return std::hash<std::string_view>()(key); }
+    };
+
+    struct Statistics
+    {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+        uint64_t coalesced = 0; // промахи, дождавшиеся вычисления в другом потоке
+
+        Statistics& operator+=(const Statistics& other) noexcept
+        {
+            hits += other.hits;
+            misses += other.misses;
+            evictions += other.evictions;
+            coalesced += other.coalesced;
+            return *this;
+        }
+    };
+
+    template<typename T>
+    class ClockCache
+    {
+        struct Slot
+        {
+            const std::string* key = nullptr; // ключ хранится в _index
+            std::optional<T> value;
+            bool referenced = false;
+        };
+
+    public:
+        explicit ClockCache(size_t capacity) : _slots(std::max<size_t>(capacity, 1))
+        {
+            _index.reserve(_slots.size());
+            _free.reserve(_slots.size());
+            for (size_t position = _slots.size(); position > 0; --position)
+                _free.push_back(position - 1);
+        }
+
+        size_t size() const noexcept { return _index.size(); }
+        size_t capacity() const noexcept { return _slots.size(); }
+        const Statistics& statistics() const noexcept { return _statistics; }
+
+        std::optional<T> get(std::string_view key)
+        {
+            auto it = _index.find(key);
+            if (it == _index.end())
+            {
+                ++_statistics.misses;
+                return std::nullopt;
+            }
+
+            ++_statistics.hits;
+            Slot& slot = _slots[it->second];
+            slot.referenced = true;
+            return slot.value;
+        }
+
+        /// Вставка или замена значения
+        void put(std::string_view key, T value)
+        {
+            if (auto it = _index.find(key); it != _index.end())
+            {
+                Slot& slot = _slots[it->second];
+                slot.value = std::move(value);
+                slot.referenced = true;
+                return;
+            }
+
+            size_t position = Evict();
+            auto [it, _] = _index.emplace(std::string(key), position);
+            Slot& slot = _slots[position];
+            slot.key = &it->first;
+            slot.value = std::move(value);
+            slot.referenced = false; // новая запись вытесняется первой, если к ней не обратятся
+        }
+
+        bool erase(std::string_view key)
+        {
+            auto it = _index.find(key);
+            if (it == _index.end())
+                return false;
+
+            Slot& slot = _slots[it->second];
+            slot.key = nullptr;
+            slot.value.reset();
+            slot.referenced = false;
+            _free.push_back(it->second);
+            _index.erase(it);
+            return true;
+        }
+
+        /// Однопоточный вариант: function(key) -> T вызывается только при промахе
+        template<typename TFunction>
+        T get_or_compute(std::string_view key, TFunction&& function)
+        {
+            if (auto value = get(key))
+                return *std::move(value);
+
+            T value = std::invoke(std::forward<TFunction>(function), key);
+            put(key, value);
+            return value;
+        }
+
+        void CountCoalesced() noexcept { ++_statistics.coalesced; }
+
+    private:
+        /// Свободная ячейка: из списка свободных (пустые и освобожденные erase), стрелка CLOCK вытесняет только в полном кэше
+        size_t Evict()
+        {
+            if (!_free.empty())
+            {
+                size_t position = _free.back();
+                _free.pop_back();
+                return position;
+            }
+
+            while (true)
+            {
+                Slot& slot = _slots[_hand];
+                size_t position = _hand;
+                _hand = (_hand + 1) % _slots.size();
+
+                if (slot.referenced)
+                {
+                    slot.referenced = false; // второй шанс
+                    continue;
+                }
+
+                _index.erase(_index.find(*slot.key));
+                slot.key = nullptr;
+                slot.value.reset();
+                ++_statistics.evictions;
+                return position;
+            }
+        }
+
+        std::vector<Slot> _slots;
+        std::unordered_map<std::string, size_t, StringHash, std::equal_to<>> _index;
+        std::vector<size_t> _free; // свободные ячейки
+        size_t _hand = 0;
+        Statistics _statistics;
+    };
+
+    template<typename T>
+    class ShardedClockCache
+    {
+        struct Shard
+        {
+            explicit Shard(size_t capacity) : cache(capacity) {}
+
+            std::mutex mutex;
+            ClockCache<T> cache;
+            std::unordered_map<std::string, std::shared_future<T>, StringHash, std::equal_to<>> pending; // вычисляемые сейчас ключи
+        };
+
+    public:
+        /// capacity делится поровну между шардами
+        explicit ShardedClockCache(size_t capacity, size_t shards = 16)
+        {
+            shards = std::max<size_t>(shards, 1);
+            _shards.reserve(shards);
+            for (size_t i = 0; i < shards; ++i)
+                _shards.push_back(std::make_unique<Shard>((capacity + shards - 1) / shards));
+        }
+
+        std::optional<T> get(std::string_view key)
+        {
+            Shard& shard = GetShard(key);
+            std::scoped_lock lock(shard.mutex);
+            return shard.cache.get(key);
+        }
+
+        void put(std::string_view key, T value)
+        {
+            Shard& shard = GetShard(key);
+            std::scoped_lock lock(shard.mutex);
+            shard.cache.put(key, std::move(value));
+        }
+
+        /// function(key) -> T вызывается вне блокировки и ровно один раз на промах, даже если промахнулись несколько потоков
+        template<typename TFunction>
+        T get_or_compute(std::string_view key, TFunction&& function)
+        {
+            Shard& shard = GetShard(key);
+            std::promise<T> promise;
+            {
+                std::unique_lock lock(shard.mutex);
+                if (auto value = shard.cache.get(key))
+                    return *std::move(value);
+
+                if (auto it = shard.pending.find(key); it != shard.pending.end())
+                {
+                    shard.cache.CountCoalesced();
+                    auto future = it->second;
+                    lock.unlock();
+                    return future.get(); // исключение из function пробрасывается всем ожидающим
+                }
+                shard.pending.emplace(std::string(key), promise.get_future().share());
+            }
+
+            try
+            {
+                T value = std::invoke(std::forward<TFunction>(function), key);
+                {
+                    std::scoped_lock lock(shard.mutex);
+                    shard.cache.put(key, value);
+                    shard.pending.erase(shard.pending.find(key));
+                }
+                promise.set_value(value);
+                return value;
+            }
+            catch (...)
+            {
+                {
+                    std::scoped_lock lock(shard.mutex);
+                    shard.pending.erase(shard.pending.find(key));
+                }
+                promise.set_exception(std::current_exception());
+                throw;
+            }
+        }
+
+        Statistics statistics() const
+        {
+            Statistics result;
+            for (const auto& shard : _shards)
+            {
+                std::scoped_lock lock(shard->mutex);
+                result += shard->cache.statistics();
+            }
+            return result;
+        }
+
+    private:
+        Shard& GetShard(std::string_view key) const
+        {
+            // Старшие биты хэша: младшие использует unordered_map внутри шарда
+            size_t hash = StringHash()(key);
+            return *_shards[(hash >> 16) % _shards.size()];
+        }
+
+        std::vector<std::unique_ptr<Shard>> _shards;
+    };
+
+    /// Распределение Ципфа: ключ k (0..count-1) выпадает с вероятностью ~ 1 / (k + 1)^s
+    class ZipfDistribution
+    {
+    public:
+        ZipfDistribution(size_t count, double s = 1.0) : _cdf(count)
+        {
+            double sum = 0;
+            for (size_t k = 0; k < count; ++k)
+                _cdf[k] = sum += 1.0 / std::pow(static_cast<double>(k + 1), s);
+            for (auto& value : _cdf)
+                value /= sum;
+        }
+
+        template<typename TGenerator>
+        size_t operator()(TGenerator& generator) const
+        {
+            double u = std::uniform_real_distribution<double>(0.0, 1.0)(generator);
+            return std::min<size_t>(std::lower_bound(_cdf.begin(), _cdf.end(), u) - _cdf.begin(), _cdf.size() - 1);
+        }
+
+    private:
+        std::vector<double> _cdf;
+    };
+}
+
+#endif /* LookupCache_h */
@@ -0,0 +1,497 @@
+#ifndef MembershipFilter_h
+#define MembershipFilter_h
+
+#include "CpuFeatures.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__AVX2__) || CPU_DISPATCH
+#include <immintrin.h>
+#define MEMBERSHIP_AVX2 1
+#endif
+#if defined(__SSE4_1__) || CPU_DISPATCH
+#include <smmintrin.h>
+#define MEMBERSHIP_SSE41 1
+#endif
+
+/*
+ Приблизительная проверка принадлежности перед поиском в реестре: большинство поисков - промахи, а промах в std::map<std::string, ...>
+ проходит все дерево со сравнением строк. Фильтр отвечает "точно нет" (тогда в map не ходим) или "возможно есть" (ищем в map).
+ Ложноотрицательных ответов нет, ложноположительные - с заданной вероятностью.
+ - BloomFilter: блочный (split block) - ключ попадает в один блок 256 бит (одна кэш-линия), в каждом из 8 слов блока ставится 1 бит,
+   номер бита - старшие 5 бит произведения хэша на свою константу. Проверка - одна загрузка блока: AVX2 - 8 умножений и сдвигов
+   одной командой и vptest, SSE4.1 - две половины по 4 слова, без них - 8 скалярных операций. Ядра AVX2 и SSE4.1 компилируются всегда
+   (CPU_TARGET) и выбираются при каждом вызове по cpuid (проверка флага), со сборкой под набор - при компиляции. Удаление не поддерживается.
+   Размер считается по заданной вероятности ложного срабатывания с учетом неравномерного заполнения блоков (распределение Пуассона).
+ - CuckooFilter: отпечатки ключей (8/16/32 бит) в корзинах по 4, у каждого ключа 2 возможные корзины (вторая = первая ^ hash(отпечаток)).
+   Проверка - 2 корзины, сравнение 4 отпечатков за одну операцию в 64-битном слове (SWAR). Поддерживает удаление.
+   Вероятность ложного срабатывания ~ 8 / 2^bits: uint8_t ~3%, uint16_t ~0.01%, uint32_t ~2e-9.
+ - Filtered<TMap, TFilter>: обертка над любым map с find/end, ключи которого - строки: find(key) сначала спрашивает фильтр.
+ Contains - const и только читает память: можно вызывать из многих потоков одновременно. Insert/Erase - как у контейнеров STL,
+ требуют внешней синхронизации с другими вызовами.
+ */
+
+namespace membership
+{
+    /// Перемешивание splitmix64: каждый бит входа влияет на все биты результата
+    constexpr uint64_t Mix(uint64_t value) noexcept
+    {
+        value ^= value >> 30;
+        value *= 0xbf58476d1ce4e5b9;
+        value ^= value >> 27;
+        value *= 0x94d049bb133111eb;
+        return value ^ (value >> 31);
+    }
+
+    /*
+     64-битный хэш строки по 8 байт за шаг. std::hash<std::string_view> возвращает size_t - в 32-битных сборках (Win32) старшие 32 бита
+     нулевые, а фильтры берут из старших бит блок (Bloom) и отпечаток (cuckoo), из младших - биты блока и корзину.
+     */
+    inline uint64_t Hash(std::string_view key) noexcept
+    {
+        uint64_t hash = 0x9e3779b97f4a7c15 ^ key.size();
+        size_t i = 0;
+        for (; i + sizeof(uint64_t) <= key.size(); i += sizeof(uint64_t))
+        {
+            uint64_t word;
+            std::memcpy(&word, key.data() + i, sizeof(word));
+            hash = Mix(hash ^ word);
+        }
+        uint64_t tail = 0;
+        if (i < key.size())
+            std::memcpy(&tail, key.data() + i, key.size() - i);
+        return Mix(hash ^ tail);
+    }
+
+    class BloomFilter
+    {
+    public:
+        /// capacity ключей с вероятностью ложного срабатывания false_positive_rate
+        explicit BloomFilter(size_t capacity, double false_positive_rate = 0.01) : _capacity(std::max<size_t>(capacity, 1)), _rate(false_positive_rate)
+        {
+            if (!(false_positive_rate > 0 && false_positive_rate < 1))
+                throw std::invalid_argument("membership::BloomFilter: false_positive_rate в (0, 1)");
+
+            // наименьшее число блоков с ожидаемой вероятностью не больше заданной
+            size_t low = 1, high = 1;
+            while (FalsePositiveRate(_capacity, high) > false_positive_rate)
+                high *= 2;
+            while (low < high)
+            {
+                const size_t middle = low + (high - low) / 2;
+                if (FalsePositiveRate(_capacity, middle) > false_positive_rate)
+                    low = middle + 1;
+                else
+                    high = middle;
+            }
+            _blocks.resize(high);
+        }
+
+        /// Пустой фильтр с теми же параметрами для capacity ключей
+        BloomFilter Resized(size_t capacity) const { return BloomFilter(capacity, _rate); }
+
+        /// false - ключей больше емкости: вероятность ложных срабатываний выше заданной, фильтр стоит пересоздать (ключ вставлен)
+        bool Insert(std::string_view key) noexcept { return Insert(Hash(key)); }
+        bool Contains(std::string_view key) const noexcept { return Contains(Hash(key)); }
+
+        bool Insert(uint64_t hash) noexcept
+        {
+            Block& block = _blocks[Index(hash)];
+            const auto key = static_cast<uint32_t>(hash);
+#if defined(MEMBERSHIP_AVX2)
+            if (cpu::HasAvx2())
+                InsertAvx2(block, key);
+            else
+#endif
+#if defined(MEMBERSHIP_SSE41)
+            if (cpu::HasSse41())
+                InsertSse41(block, key);
+            else
+#endif
+            {
+                for (size_t i = 0; i < 8; ++i)
+                    block.words[i] |= Bit(key, i);
+            }
+            return ++_size <= _capacity;
+        }
+
+        bool Contains(uint64_t hash) const noexcept
+        {
+            const Block& block = _blocks[Index(hash)];
+            const auto key = static_cast<uint32_t>(hash);
+#if defined(MEMBERSHIP_AVX2)
+            if (cpu::HasAvx2())
+                return ContainsAvx2(block, key);
+#endif
+#if defined(MEMBERSHIP_SSE41)
+            if (cpu::HasSse41())
+                return ContainsSse41(block, key);
+#endif
+            uint32_t missing = 0;
+            for (size_t i = 0; i < 8; ++i)
+                missing |= Bit(key, i) & ~block.words[i];
+            return missing == 0;
+        }
+
+        size_t size() const noexcept { return _size; }
+        size_t capacity() const noexcept { return _capacity; }
+        size_t memory() const noexcept { return _blocks.size() * sizeof(Block); }
+
+        /// Ожидаемая вероятность ложного срабатывания при keys ключах в blocks блоках
+        static double FalsePositiveRate(size_t keys, size_t blocks)
+        {
+            // ключей в блоке ~ Poisson(lambda); при j ключах бит слова занят с вероятностью 1 - (31/32)^j, проверяются 8 слов
+            const double lambda = static_cast<double>(keys) / static_cast<double>(blocks);
+            // вероятности Пуассона через логарифмы: exp(-lambda) для больших lambda уходит в 0
+            const double spread = 12 * std::sqrt(lambda) + 32;
+            const auto first = static_cast<size_t>(std::max(lambda - spread, 0.0)), last = static_cast<size_t>(lambda + spread);
+            double result = 0;
+            for (size_t j = first; j <= last; ++j)
+            {
+                const auto count = static_cast<double>(j);
+                const double probability = std::exp(count * std::log(lambda) - lambda - std::lgamma(count + 1));
+                result += probability * std::pow(1 - std::pow(31.0 / 32.0, count), 8);
+            }
+            return result;
+        }
+
+    private:
+        struct alignas(32) Block
+        {
+            uint32_t words[8] {};
+        };
+
+        /// Константы из спецификации split block Bloom filter (Apache Parquet)
+        static constexpr uint32_t salts[8] = {0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU, 0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U};
+
+        /// Блок по старшим 32 битам хэша: (h * blocks) >> 32 вместо деления
+        size_t Index(uint64_t hash) const noexcept
+        {
+            return static_cast<size_t>(((hash >> 32) * _blocks.size()) >> 32);
+        }
+
+        static uint32_t Bit(uint32_t key, size_t word) noexcept
+        {
+            return uint32_t(1) << ((key * salts[word]) >> 27);
+        }
+
+#if defined(MEMBERSHIP_AVX2)
+        CPU_TARGET("avx2") static __m256i MaskAvx2(uint32_t key) noexcept
+        {
+            const __m256i salt = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(salts));
+            const __m256i shifts = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_set1_epi32(static_cast<int>(key)), salt), 27);
+            return _mm256_sllv_epi32(_mm256_set1_epi32(1), shifts);
+        }
+
+        CPU_TARGET("avx2") static void InsertAvx2(Block& block, uint32_t key) noexcept
+        {
+            const __m256i words = _mm256_load_si256(reinterpret_cast<const __m256i*>(block.words));
+            _mm256_store_si256(reinterpret_cast<__m256i*>(block.words), _mm256_or_si256(words, MaskAvx2(key)));
+        }
+
+        CPU_TARGET("avx2") static bool ContainsAvx2(const Block& block, uint32_t key) noexcept
+        {
+            const __m256i words = _mm256_load_si256(reinterpret_cast<const __m256i*>(block.words));
+            return _mm256_testc_si256(words, MaskAvx2(key)); // (~words & mask) == 0
+        }
+#endif
+#if defined(MEMBERSHIP_SSE41)
+        /// 1 << shift без сдвига на переменную (его нет до AVX2): 2^shift как float -> int; для 31 cvttps дает 0x80000000 = 1 << 31
+        CPU_TARGET("sse4.1") static __m128i PowerOfTwo(__m128i shifts) noexcept
+        {
+            return _mm_cvttps_epi32(_mm_castsi128_ps(_mm_add_epi32(_mm_slli_epi32(shifts, 23), _mm_set1_epi32(0x3f800000))));
+        }
+
+        struct Masks
+        {
+            __m128i low, high; // слова 0-3 и 4-7
+        };
+
+        CPU_TARGET("sse4.1") static Masks MaskSse41(uint32_t key) noexcept
+        {
+            const __m128i value = _mm_set1_epi32(static_cast<int>(key));
+            const __m128i low = _mm_srli_epi32(_mm_mullo_epi32(value, _mm_loadu_si128(reinterpret_cast<const __m128i*>(salts))), 27);
+            const __m128i high = _mm_srli_epi32(_mm_mullo_epi32(value, _mm_loadu_si128(reinterpret_cast<const __m128i*>(salts + 4))), 27);
+            return {PowerOfTwo(low), PowerOfTwo(high)};
+        }
+
+        CPU_TARGET("sse4.1") static void InsertSse41(Block& block, uint32_t key) noexcept
+        {
+            const auto [low, high] = MaskSse41(key);
+            auto* words = reinterpret_cast<__m128i*>(block.words);
+            _mm_store_si128(words, _mm_or_si128(_mm_load_si128(words), low));
+            _mm_store_si128(words + 1, _mm_or_si128(_mm_load_si128(words + 1), high));
+        }
+
+        CPU_TARGET("sse4.1") static bool ContainsSse41(const Block& block, uint32_t key) noexcept
+        {
+            const auto [low, high] = MaskSse41(key);
+            const auto* words = reinterpret_cast<const __m128i*>(block.words);
+            return _mm_testc_si128(_mm_load_si128(words), low) & _mm_testc_si128(_mm_load_si128(words + 1), high);
+        }
+#endif
+
+        std::vector<Block> _blocks;
+        size_t _capacity;
+        double _rate;
+        size_t _size = 0;
+    };
+
+    /// TFingerprint - размер отпечатка: uint8_t, uint16_t или uint32_t
+    template<typename TFingerprint = uint16_t>
+    class CuckooFilter
+    {
+        static_assert(std::is_same_v<TFingerprint, uint8_t> || std::is_same_v<TFingerprint, uint16_t> || std::is_same_v<TFingerprint, uint32_t>,
+                      "membership::CuckooFilter: отпечаток - uint8_t, uint16_t или uint32_t");
+
+    public:
+        static constexpr size_t slots = 4; // отпечатков в корзине
+
+        explicit CuckooFilter(size_t capacity)
+            : _buckets(std::bit_ceil(std::max<size_t>((capacity * 100 / 95 + slots - 1) / slots, 2))), _mask(_buckets.size() - 1), _capacity(capacity) {}
+
+        CuckooFilter Resized(size_t capacity) const { return CuckooFilter(capacity); }
+
+        /// Вероятность ложного срабатывания при полном заполнении: 2 корзины по 4 отпечатка
+        static constexpr double FalsePositiveRate() noexcept
+        {
+            return 2.0 * slots / std::pow(2.0, sizeof(TFingerprint) * 8);
+        }
+
+        /// false - нет места (после 500 перемещений): фильтр нужно пересоздать большего размера. Повторная вставка ключа добавляет копию
+        bool Insert(std::string_view key) noexcept { return Insert(Hash(key)); }
+        bool Contains(std::string_view key) const noexcept { return Contains(Hash(key)); }
+        /// Удаляет одну копию отпечатка ключа; удалять можно только вставленные ключи, иначе будут ложноотрицательные ответы
+        bool Erase(std::string_view key) noexcept { return Erase(Hash(key)); }
+
+        bool Insert(uint64_t hash) noexcept
+        {
+            if (_has_victim)
+                return false;
+            TFingerprint fingerprint = Fingerprint(hash);
+            size_t index = hash & _mask;
+            if (Place(index, fingerprint) || Place(Alternate(index, fingerprint), fingerprint))
+            {
+                ++_size;
+                return true;
+            }
+
+            // вытесняем случайный отпечаток в его другую корзину
+            index = (_random & 1) ? index : Alternate(index, fingerprint);
+            for (size_t kick = 0; kick < max_kicks; ++kick)
+            {
+                _random ^= _random << 13;
+                _random ^= _random >> 7;
+                _random ^= _random << 17;
+                std::swap(fingerprint, _buckets[index].fingerprints[_random % slots]);
+                index = Alternate(index, fingerprint);
+                if (Place(index, fingerprint))
+                {
+                    ++_size;
+                    return true;
+                }
+            }
+            // последний вытесненный отпечаток хранится отдельно, чтобы не было ложноотрицательных ответов
+            _victim = {index, fingerprint};
+            _has_victim = true;
+            ++_size;
+            return false;
+        }
+
+        bool Contains(uint64_t hash) const noexcept
+        {
+            const TFingerprint fingerprint = Fingerprint(hash);
+            const size_t first = hash & _mask, second = Alternate(first, fingerprint);
+            return Has(_buckets[first], fingerprint) || Has(_buckets[second], fingerprint) ||
+                   (_has_victim && _victim.fingerprint == fingerprint && (_victim.index == first || _victim.index == second));
+        }
+
+        bool Erase(uint64_t hash) noexcept
+        {
+            const TFingerprint fingerprint = Fingerprint(hash);
+            const size_t first = hash & _mask, second = Alternate(first, fingerprint);
+            for (size_t index : {first, second})
+                for (TFingerprint& slot : _buckets[index].fingerprints)
+                    if (slot == fingerprint)
+                    {
+                        slot = 0;
+                        --_size;
+                        TryPlaceVictim();
+                        return true;
+                    }
+            if (_has_victim && _victim.fingerprint == fingerprint && (_victim.index == first || _victim.index == second))
+            {
+                _has_victim = false;
+                --_size;
+                return true;
+            }
+            return false;
+        }
+
+        size_t size() const noexcept { return _size; }
+        size_t capacity() const noexcept { return _capacity; }
+        size_t memory() const noexcept { return _buckets.size() * sizeof(Bucket); }
+
+    private:
+        static constexpr size_t max_kicks = 500;
+
+        struct alignas(slots * sizeof(TFingerprint)) Bucket
+        {
+            TFingerprint fingerprints[slots] {}; // 0 - пустое место
+        };
+
+        struct Victim
+        {
+            size_t index = 0;
+            TFingerprint fingerprint = 0;
+        };
+
+        /// Биты хэша выше индекса корзины; 0 зарезервирован под пустое место
+        static TFingerprint Fingerprint(uint64_t hash) noexcept
+        {
+            const auto fingerprint = static_cast<TFingerprint>(hash >> (64 - sizeof(TFingerprint) * 8));
+            return fingerprint ? fingerprint : 1;
+        }
+
+        /// Вторая корзина: index ^ hash(fingerprint), обратимо - из любой корзины получается другая
+        size_t Alternate(size_t index, TFingerprint fingerprint) const noexcept
+        {
+            return (index ^ (static_cast<uint64_t>(fingerprint) * 0x5bd1e995u)) & _mask;
+        }
+
+        bool Place(size_t index, TFingerprint fingerprint) noexcept
+        {
+            for (TFingerprint& slot : _buckets[index].fingerprints)
+                if (slot == 0)
+                {
+                    slot = fingerprint;
+                    return true;
+                }
+            return false;
+        }
+
+        /// Есть ли fingerprint среди 4 отпечатков корзины: для 8 и 16 бит - одно слово и поиск нулевого отпечатка в xor (SWAR)
+        static bool Has(const Bucket& bucket, TFingerprint fingerprint) noexcept
+        {
+            if constexpr (sizeof(TFingerprint) == 4)
+                return (bucket.fingerprints[0] == fingerprint) | (bucket.fingerprints[1] == fingerprint) | (bucket.fingerprints[2] == fingerprint) | (bucket.fingerprints[3] == fingerprint);
+            else
+            {
+                using Word = std::conditional_t<sizeof(TFingerprint) == 1, uint32_t, uint64_t>;
+                constexpr Word ones = ~Word(0) / std::numeric_limits<TFingerprint>::max();  // 0x01010101 или 0x0001000100010001
+                constexpr Word highs = ones << (sizeof(TFingerprint) * 8 - 1);              // 0x80808080 или 0x8000800080008000
+                Word word;
+                std::memcpy(&word, bucket.fingerprints, sizeof(word));
+                word ^= ones * fingerprint;
+                return ((word - ones) & ~word & highs) != 0;
+            }
+        }
+
+        void TryPlaceVictim() noexcept
+        {
+            if (_has_victim && (Place(_victim.index, _victim.fingerprint) || Place(Alternate(_victim.index, _victim.fingerprint), _victim.fingerprint)))
+                _has_victim = false;
+        }
+
+        std::vector<Bucket> _buckets;
+        size_t _mask;
+        size_t _capacity;
+        size_t _size = 0;
+        uint64_t _random = 0x9e3779b97f4a7c15;
+        Victim _victim;
+        bool _has_victim = false;
+    };
+
+    /*
+     Фильтр перед map со строковыми ключами: промах отсекается фильтром без поиска в map.
+     TMap - std::map, std::unordered_map, containers::flat_map и т.п.; поиск по std::string_view, если map его поддерживает
+     (std::less<>, flat_map), иначе через временную key_type. Если фильтр переполнен, он пересоздается вдвое большим по ключам map.
+     */
+    template<typename TMap, typename TFilter = BloomFilter>
+    class Filtered
+    {
+    public:
+        using const_iterator = typename TMap::const_iterator;
+
+        Filtered(TMap map, TFilter filter) : _map(std::move(map)), _filter(std::move(filter))
+        {
+            Rebuild(std::max(_filter.capacity(), _map.size()));
+        }
+
+        const_iterator find(std::string_view key) const
+        {
+            if (!_filter.Contains(key))
+                return _map.end();
+            if constexpr (requires { _map.find(key); })
+                return _map.find(key);
+            else
+                return _map.find(typename TMap::key_type(key));
+        }
+
+        bool contains(std::string_view key) const { return find(key) != _map.end(); }
+        const_iterator end() const noexcept { return _map.end(); }
+
+        /// Вставка, если ключа нет (значение существующего ключа не меняется)
+        template<typename TValue>
+        bool insert(std::string_view key, TValue&& value)
+        {
+            bool inserted;
+            if constexpr (requires { _map.try_emplace(typename TMap::key_type(key), std::forward<TValue>(value)); })
+                inserted = _map.try_emplace(typename TMap::key_type(key), std::forward<TValue>(value)).second;
+            else
+                inserted = _map.insert(typename TMap::key_type(key), std::forward<TValue>(value)).second;
+            if (inserted && !_filter.Insert(key))
+                Rebuild(_map.size() * 2);
+            return inserted;
+        }
+
+        /// Bloom не удаляет: ключ остается в фильтре (лишний поиск в map), cuckoo - удаляет
+        size_t erase(std::string_view key)
+        {
+            size_t erased;
+            if constexpr (requires { _map.erase(key); })
+                erased = _map.erase(key);
+            else
+                erased = _map.erase(typename TMap::key_type(key));
+            if constexpr (requires { _filter.Erase(key); })
+                if (erased)
+                    _filter.Erase(key);
+            return erased;
+        }
+
+        const TMap& map() const noexcept { return _map; }
+        const TFilter& filter() const noexcept { return _filter; }
+
+    private:
+        void Rebuild(size_t capacity)
+        {
+            while (true)
+            {
+                _filter = _filter.Resized(capacity);
+                bool full = false;
+                for (const auto& [key, value] : _map)
+                    full |= !_filter.Insert(std::string_view(key));
+                if (!full)
+                    return;
+                capacity *= 2;
+            }
+        }
+
+        TMap _map;
+        TFilter _filter;
+    };
+}
+
+#endif /* MembershipFilter_h */
@@ -0,0 +1,361 @@
+#ifndef Metrics_h
+#define Metrics_h
+
+#include "JsonString.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+ Счетчики и гистограммы для всех потоков, объявляемые как static inline члены (C++17, см. static_inline::C17::Y::i в main.cpp):
+     struct Metrics
+     {
+         static inline metrics::Counter requests {"requests"};
+         static inline metrics::Histogram latency {"latency_ns"};
+     };
+     Metrics::requests.Increment();
+     Metrics::latency.Record(ns);
+
+ Один static inline std::atomic, который увеличивают все потоки, - одна кэш-линия, которая постоянно переходит между ядрами (false sharing и
+ конкуренция за линию). Здесь у каждого счетчика слоты по потокам, каждый слот в своей кэш-линии (hardware_destructive_interference_size):
+ поток пишет только в свой слот, сумма по слотам считается лениво при чтении. Если потоков больше, чем слотов, слоты делятся (запись атомарна).
+
+ Histogram - логарифмически-линейные корзины как в HDR Histogram: 2^precision_bits корзин на каждую степень двойки,
+ относительная погрешность значения не больше 2^-precision_bits (3% при 5 битах) во всем диапазоне uint64_t.
+ Registry::Snapshot() - значения всех метрик на момент чтения; WriteJson/WriteText - экспорт.
+ */
+
+namespace metrics
+{
+#if defined(__cpp_lib_hardware_interference_size)
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Winterference-size" // значение зависит от -mtune: здесь оно не часть ABI
+#endif
+    inline constexpr size_t cache_line_size = std::hardware_destructive_interference_size;
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#else
+    inline constexpr size_t cache_line_size = 64;
+#endif
+
+    /// Номер слота текущего потока: потоки получают слоты по кругу
+    inline size_t ThreadSlot() noexcept
+    {
+        static std::atomic<size_t> next {0};
+        thread_local const size_t slot = next.fetch_add(1, std::memory_order_relaxed);
+        return slot;
+    }
+
+    class Metric;
+
+    /// Список всех метрик программы. Метрики регистрируются в конструкторе и удаляются из списка в деструкторе
+    class Registry
+    {
+    public:
+        static Registry& Instance()
+        {
+            static Registry registry; // создается при первом обращении, поэтому доступен из конструкторов static inline метрик
+            return registry;
+        }
+
+        struct Sample
+        {
+            std::string name;
+            bool histogram = false;
+            int64_t value = 0;  // счетчик
+            uint64_t count = 0; // гистограмма
+            uint64_t min = 0;
+            uint64_t max = 0;
+            double mean = 0;
+            uint64_t p50 = 0;
+            uint64_t p90 = 0;
+            uint64_t p99 = 0;
+            uint64_t p999 = 0;
+        };
+
+        std::vector<Sample> Snapshot() const;
+
+        void Add(Metric* metric)
+        {
+            std::lock_guard lock(_mutex);
+            _metrics.push_back(metric);
+        }
+
+        void Remove(Metric* metric)
+        {
+            std::lock_guard lock(_mutex);
+            std::erase(_metrics, metric);
+        }
+
+    private:
+        Registry() = default;
+
+        mutable std::mutex _mutex;
+        std::vector<Metric*> _metrics;
+    };
+
+    class Metric
+    {
+    public:
+        explicit Metric(std::string_view name) : _name(name)
+        {
+            Registry::Instance().Add(this);
+        }
+
+        virtual ~Metric()
+        {
+            Registry::Instance().Remove(this);
+        }
+
+        Metric(const Metric&) = delete;
+        Metric& operator=(const Metric&) = delete;
+
+        const std::string& name() const noexcept { return _name; }
+        virtual Registry::Sample Sample() const = 0;
+
+    private:
+        std::string _name;
+    };
+
+    template<size_t Slots = 64>
+    class BasicCounter : public Metric
+    {
+    public:
+        using Metric::Metric;
+
+        void Add(int64_t delta) noexcept
+        {
+            _slots[ThreadSlot() % Slots].value.fetch_add(delta, std::memory_order_relaxed);
+        }
+
+        void Increment() noexcept { Add(1); }
+
+        /// Сумма по слотам: значения, записанные одновременно с чтением, могут не попасть
+        int64_t value() const noexcept
+        {
+            int64_t sum = 0;
+            for (const Slot& slot : _slots)
+                sum += slot.value.load(std::memory_order_relaxed);
+            return sum;
+        }
+
+        void Reset() noexcept
+        {
+            for (Slot& slot : _slots)
+                slot.value.store(0, std::memory_order_relaxed);
+        }
+
+        Registry::Sample Sample() const override
+        {
+            Registry::Sample sample;
+            sample.name = name();
+            sample.value = value();
+            return sample;
+        }
+
+    private:
+        struct alignas(cache_line_size) Slot
+        {
+            std::atomic<int64_t> value {0};
+        };
+
+        std::array<Slot, Slots> _slots;
+    };
+
+    using Counter = BasicCounter<>;
+
+    /// Корзины HDR: значения до 2^(P+1) точные, дальше 2^P корзин на степень двойки
+    template<unsigned PrecisionBits = 5>
+    struct Buckets
+    {
+        static_assert(PrecisionBits >= 1 && PrecisionBits <= 16);
+        static constexpr size_t sub_buckets = size_t(1) << PrecisionBits;
+        static constexpr size_t count = (65 - PrecisionBits) * sub_buckets;
+
+        static constexpr size_t Index(uint64_t value) noexcept
+        {
+            if (value < 2 * sub_buckets)
+                return static_cast<size_t>(value);
+            unsigned shift = static_cast<unsigned>(std::bit_width(value)) - PrecisionBits - 1;
+            return shift * sub_buckets + static_cast<size_t>(value >> shift);
+        }
+
+        /// Наименьшее значение в корзине
+        static constexpr uint64_t Lower(size_t index) noexcept
+        {
+            if (index < 2 * sub_buckets)
+                return index;
+            size_t shift = index / sub_buckets - 1;
+            return static_cast<uint64_t>(index - shift * sub_buckets) << shift;
+        }
+
+        /// Наибольшее значение в корзине
+        static constexpr uint64_t Upper(size_t index) noexcept
+        {
+            return index + 1 < count ? Lower(index + 1) - 1 : std::numeric_limits<uint64_t>::max();
+        }
+    };
+
+    template<unsigned PrecisionBits = 5, size_t Slots = 16>
+    class BasicHistogram : public Metric
+    {
+    public:
+        using Buckets = metrics::Buckets<PrecisionBits>;
+
+        explicit BasicHistogram(std::string_view name) : Metric(name), _slots(std::make_unique<Slot[]>(Slots)) {}
+
+        void Record(uint64_t value) noexcept
+        {
+            Slot& slot = _slots[ThreadSlot() % Slots];
+            slot.buckets[Buckets::Index(value)].fetch_add(1, std::memory_order_relaxed);
+            slot.sum.fetch_add(value, std::memory_order_relaxed);
+        }
+
+        /// Сумма корзин всех слотов
+        struct Snapshot
+        {
+            std::vector<uint64_t> buckets = std::vector<uint64_t>(Buckets::count);
+            uint64_t count = 0;
+            uint64_t sum = 0;
+
+            /// Верхняя граница корзины, в которую попадает перцентиль: погрешность в пределах ширины корзины
+            uint64_t Percentile(double percent) const noexcept
+            {
+                if (!count)
+                    return 0;
+                uint64_t rank = static_cast<uint64_t>(percent / 100.0 * static_cast<double>(count - 1)) + 1;
+                uint64_t seen = 0;
+                for (size_t i = 0; i < buckets.size(); ++i)
+                {
+                    seen += buckets[i];
+                    if (seen >= rank)
+                        return Buckets::Upper(i);
+                }
+                return Buckets::Upper(buckets.size() - 1);
+            }
+
+            uint64_t Min() const noexcept
+            {
+                auto it = std::find_if(buckets.begin(), buckets.end(), [](uint64_t n) { return n != 0; });
+                return it == buckets.end() ? 0 : Buckets::Lower(static_cast<size_t>(it - buckets.begin()));
+            }
+
+            uint64_t Max() const noexcept
+            {
+                auto it = std::find_if(buckets.rbegin(), buckets.rend(), [](uint64_t n) { return n != 0; });
+                return it == buckets.rend() ? 0 : Buckets::Upper(static_cast<size_t>(buckets.rend() - it - 1));
+            }
+
+            double Mean() const noexcept { return count ? static_cast<double>(sum) / static_cast<double>(count) : 0; }
+        };
+
+        Snapshot snapshot() const
+        {
+            Snapshot result;
+            for (size_t s = 0; s < Slots; ++s)
+            {
+                const Slot& slot = _slots[s];
+                for (size_t i = 0; i < Buckets::count; ++i)
+                {
+                    uint64_t n = slot.buckets[i].load(std::memory_order_relaxed);
+                    result.buckets[i] += n;
+                    result.count += n;
+                }
+                result.sum += slot.sum.load(std::memory_order_relaxed);
+            }
+            return result;
+        }
+
+        Registry::Sample Sample() const override
+        {
+            Snapshot current = snapshot();
+            Registry::Sample sample;
+            sample.name = name();
+            sample.histogram = true;
+            sample.count = current.count;
+            sample.min = current.Min();
+            sample.max = current.Max();
+            sample.mean = current.Mean();
+            sample.p50 = current.Percentile(50);
+            sample.p90 = current.Percentile(90);
+            sample.p99 = current.Percentile(99);
+            sample.p999 = current.Percentile(99.9);
+            return sample;
+        }
+
+    private:
+        /// Слот занимает целое число кэш-линий: соседние потоки не пишут в одну линию
+        struct alignas(cache_line_size) Slot
+        {
+            std::array<std::atomic<uint64_t>, Buckets::count> buckets {};
+            std::atomic<uint64_t> sum {0};
+        };
+
+        std::unique_ptr<Slot[]> _slots; // ~15 КБ на слот при 5 битах: в куче, а не в статической памяти
+    };
+
+    using Histogram = BasicHistogram<>;
+
+    inline std::vector<Registry::Sample> Registry::Snapshot() const
+    {
+        std::lock_guard lock(_mutex);
+        std::vector<Sample> samples;
+        samples.reserve(_metrics.size());
+        for (const Metric* metric : _metrics)
+            samples.push_back(metric->Sample());
+        return samples;
+    }
+
+    inline void WriteJson(std::ostream& out, const std::vector<Registry::Sample>& samples)
+    {
+        out << "{";
+        for (size_t i = 0; i < samples.size(); ++i)
+        {
+            const Registry::Sample& sample = samples[i];
+            out << (i ? "," : "") << json::String(sample.name) << ':';
+            if (sample.histogram)
+            {
+                out << "{\"count\":" << sample.count << ",\"min\":" << sample.min << ",\"max\":" << sample.max << ",\"mean\":" << sample.mean
+                    << ",\"p50\":" << sample.p50 << ",\"p90\":" << sample.p90 << ",\"p99\":" << sample.p99 << ",\"p999\":" << sample.p999 << '}';
+            }
+            else
+            {
+                out << sample.value;
+            }
+        }
+        out << "}\n";
+    }
+
+    /// Одна строка на метрику: name value / name count=... p50=...
+    inline void WriteText(std::ostream& out, const std::vector<Registry::Sample>& samples)
+    {
+        for (const Registry::Sample& sample : samples)
+        {
+            out << sample.name;
+            if (sample.histogram)
+            {
+                out << " count=" << sample.count << " min=" << sample.min << " mean=" << sample.mean << " p50=" << sample.p50 << " p90=" << sample.p90
+                    << " p99=" << sample.p99 << " p999=" << sample.p999 << " max=" << sample.max << '\n';
+            }
+            else
+            {
+                out << ' ' << sample.value << '\n';
+            }
+        }
+    }
+}
+
+#endif /* Metrics_h */
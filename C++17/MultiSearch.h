@@ -0,0 +1,410 @@
+#ifndef MultiSearch_h
+#define MultiSearch_h
+
+#include "CpuFeatures.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <queue>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(__SSSE3__) || CPU_DISPATCH
+#include <tmmintrin.h>
+#define MULTI_SEARCH_SSSE3 1
+#endif
+
+/*
+ Поиск сразу нескольких подстрок (ключевые слова, разделители) за один проход по std::string_view - вместо цикла text.find(pattern) по каждой.
+ Находятся все вхождения, в том числе перекрывающиеся: Match{позиция начала, номер подстроки}.
+ - Engine::Teddy (небольшие наборы, до 16 подстрок): фильтр по первым 1-3 байтам, подстроки разложены по 8 корзинам (биты маски).
+   SSSE3: 16 позиций за раз - pshufb по младшему и старшему полубайту каждого байта дает маску корзин (алгоритм Teddy из Hyperscan),
+   без SSSE3 - таблица из 256 масок на каждый из первых байтов. Кандидаты проверяются memcmp. SSSE3-цикл компилируется всегда
+   (CPU_TARGET) и выбирается во время выполнения по cpuid, если сборка не для SSSE3.
+ - Engine::AhoCorasick (большие наборы): автомат по классам байтов (байты, не встречающиеся в подстроках, - один класс),
+   переходы достроены до DFA - один табличный переход на байт входа, вне зависимости от числа подстрок.
+ Stream - поиск по частям (буферы чтения, сетевые пакеты): Aho-Corasick хранит состояние автомата, Teddy - хвост из (длина - 1) байтов,
+ позиции считаются от начала потока. Naive - эталон на std::string_view::find для проверки.
+ */
+
+namespace search
+{
+    struct Match
+    {
+        size_t position = 0; // начало вхождения
+        size_t pattern = 0;  // номер подстроки
+
+        friend bool operator==(const Match&, const Match&) = default;
+        friend auto operator<=>(const Match&, const Match&) = default;
+    };
+
+    enum class Engine
+    {
+        Auto,
+        Teddy,
+        AhoCorasick
+    };
+
+    /// Эталон: text.find для каждой подстроки, результат отсортирован по (position, pattern)
+    inline std::vector<Match> Naive(const std::vector<std::string>& patterns, std::string_view text)
+    {
+        std::vector<Match> matches;
+        for (size_t pattern = 0; pattern < patterns.size(); ++pattern)
+            for (size_t position = text.find(patterns[pattern]); position != std::string_view::npos; position = text.find(patterns[pattern], position + 1))
+                matches.push_back({position, pattern});
+        std::sort(matches.begin(), matches.end());
+        return matches;
+    }
+
+    class Searcher
+    {
+    public:
+        static constexpr size_t teddy_limit = 16;
+
+        explicit Searcher(std::vector<std::string> patterns, Engine engine = Engine::Auto) : _patterns(std::move(patterns))
+        {
+            if (_patterns.empty())
+                throw std::invalid_argument("search: no patterns");
+            for (const std::string& pattern : _patterns)
+            {
+                if (pattern.empty())
+                    throw std::invalid_argument("search: empty pattern");
+                _min_length = std::min(_min_length, pattern.size());
+                _max_length = std::max(_max_length, pattern.size());
+            }
+
+            _engine = engine != Engine::Auto ? engine : _patterns.size() <= teddy_limit ? Engine::Teddy : Engine::AhoCorasick;
+            if (_engine == Engine::Teddy)
+                BuildTeddy();
+            else
+                BuildAhoCorasick();
+        }
+
+        Engine engine() const noexcept { return _engine; }
+        const std::vector<std::string>& patterns() const noexcept { return _patterns; }
+
+        /// on_match(Match) для каждого вхождения; offset прибавляется к позициям
+        template<typename TCallback>
+        void FindAll(std::string_view text, TCallback&& on_match, size_t offset = 0) const
+        {
+            if (_engine == Engine::Teddy)
+                Teddy(text, on_match, offset);
+            else
+            {
+                uint32_t state = 0;
+                AhoCorasick(text, state, on_match, offset);
+            }
+        }
+
+        /// Все вхождения, отсортированные по (position, pattern) - как Naive
+        std::vector<Match> FindAll(std::string_view text) const
+        {
+            std::vector<Match> matches;
+            FindAll(text, [&matches](const Match& match) { matches.push_back(match); });
+            std::sort(matches.begin(), matches.end());
+            return matches;
+        }
+
+        /// Поиск по частям: вхождения на стыке частей находятся, позиции - от начала потока. Порядок внутри части не гарантирован
+        class Stream
+        {
+        public:
+            explicit Stream(const Searcher& searcher) : _searcher(searcher) {}
+
+            template<typename TCallback>
+            void Feed(std::string_view chunk, TCallback&& on_match)
+            {
+                if (_searcher._engine == Engine::AhoCorasick)
+                    _searcher.AhoCorasick(chunk, _state, on_match, _offset);
+                else
+                {
+                    // Вхождения, начинающиеся в хвосте прошлых частей и заканчивающиеся в этой
+                    if (!_tail.empty())
+                    {
+                        const size_t tail_size = _tail.size();
+                        const size_t tail_offset = _offset - tail_size;
+                        _window.assign(_tail).append(chunk.substr(0, _searcher._max_length - 1));
+                        _searcher.Teddy(_window, [&](const Match& match)
+                        {
+                            if (match.position < tail_size && match.position + _searcher._patterns[match.pattern].size() > tail_size)
+                                on_match(Match{tail_offset + match.position, match.pattern});
+                        });
+                    }
+                    _searcher.Teddy(chunk, on_match, _offset);
+
+                    const size_t keep = _searcher._max_length - 1;
+                    if (chunk.size() >= keep)
+                        _tail.assign(chunk.substr(chunk.size() - keep));
+                    else
+                    {
+                        _tail.append(chunk);
+                        _tail.erase(0, _tail.size() - std::min(_tail.size(), keep));
+                    }
+                }
+                _offset += chunk.size();
+            }
+
+            size_t offset() const noexcept { return _offset; }
+
+        private:
+            const Searcher& _searcher;
+            size_t _offset = 0;
+            uint32_t _state = 0;
+            std::string _tail;
+            std::string _window;
+        };
+
+    private:
+        static constexpr size_t buckets = 8;
+        static constexpr uint32_t output_flag = 1u << 31;
+
+        /// Подстроки раскладываются по 8 корзинам: отсортированные по началу, подряд - похожие начала в одной корзине
+        void BuildTeddy()
+        {
+            _filter_length = std::min<size_t>(_min_length, 3);
+
+            std::vector<size_t> order(_patterns.size());
+            for (size_t i = 0; i < order.size(); ++i)
+                order[i] = i;
+            std::sort(order.begin(), order.end(), [this](size_t a, size_t b) { return _patterns[a] < _patterns[b]; });
+            for (size_t i = 0; i < order.size(); ++i)
+                _buckets[i * buckets / order.size()].push_back(order[i]);
+
+            for (size_t bucket = 0; bucket < buckets; ++bucket)
+                for (size_t pattern : _buckets[bucket])
+                    for (size_t k = 0; k < _filter_length; ++k)
+                    {
+                        auto c = static_cast<unsigned char>(_patterns[pattern][k]);
+                        _byte_masks[k][c] |= static_cast<uint8_t>(1u << bucket);
+                        _low_masks[k][c & 0x0F] |= static_cast<uint8_t>(1u << bucket);
+                        _high_masks[k][c >> 4] |= static_cast<uint8_t>(1u << bucket);
+                    }
+        }
+
+        template<typename TCallback>
+        void Verify(std::string_view text, size_t position, uint8_t candidates, TCallback& on_match, size_t offset) const
+        {
+            while (candidates)
+            {
+                const size_t bucket = static_cast<size_t>(std::countr_zero(candidates));
+                candidates &= static_cast<uint8_t>(candidates - 1);
+                for (size_t pattern : _buckets[bucket])
+                {
+                    const std::string& needle = _patterns[pattern];
+                    if (needle.size() <= text.size() - position && std::memcmp(text.data() + position, needle.data(), needle.size()) == 0)
+                        on_match(Match{offset + position, pattern});
+                }
+            }
+        }
+
+        template<typename TCallback>
+        void Teddy(std::string_view text, TCallback&& on_match, size_t offset = 0) const
+        {
+            if (text.size() < _min_length)
+                return;
+            const size_t last = text.size() - _min_length; // последняя возможная позиция начала
+            const auto* data = reinterpret_cast<const unsigned char*>(text.data());
+            size_t position = 0;
+
+#if defined(MULTI_SEARCH_SSSE3)
+            if (cpu::HasSsse3())
+                position = TeddySsse3(text, on_match, offset);
+#endif
+            for (; position <= last; ++position)
+            {
+                uint8_t candidates = _byte_masks[0][data[position]];
+                for (size_t k = 1; k < _filter_length && candidates; ++k)
+                    candidates &= _byte_masks[k][data[position + k]];
+                if (candidates)
+                    Verify(text, position, candidates, on_match, offset);
+            }
+        }
+
+#if defined(MULTI_SEARCH_SSSE3)
+        /// Блоки по 16 позиций начала, пока байты фильтра помещаются в text; возвращает первую непроверенную позицию
+        template<typename TCallback>
+        CPU_TARGET("ssse3") size_t TeddySsse3(std::string_view text, TCallback& on_match, size_t offset) const
+        {
+            const auto* data = reinterpret_cast<const unsigned char*>(text.data());
+            size_t position = 0;
+
+            const __m128i nibble = _mm_set1_epi8(0x0F);
+            __m128i low[3], high[3];
+            for (size_t k = 0; k < _filter_length; ++k)
+            {
+                low[k] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_low_masks[k].data()));
+                high[k] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_high_masks[k].data()));
+            }
+            // 16 позиций начала: байт k каждого кандидата загружается со сдвигом k
+            for (; position + 16 + _filter_length - 1 <= text.size(); position += 16)
+            {
+                __m128i candidates = _mm_set1_epi8(-1);
+                for (size_t k = 0; k < _filter_length; ++k)
+                {
+                    const __m128i input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + position + k));
+                    candidates = _mm_and_si128(candidates, _mm_and_si128(
+                        _mm_shuffle_epi8(low[k], _mm_and_si128(input, nibble)),
+                        _mm_shuffle_epi8(high[k], _mm_and_si128(_mm_srli_epi16(input, 4), nibble))));
+                }
+                unsigned mask = ~static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(candidates, _mm_setzero_si128()))) & 0xFFFF;
+                if (!mask)
+                    continue;
+                alignas(16) uint8_t lanes[16];
+                _mm_store_si128(reinterpret_cast<__m128i*>(lanes), candidates);
+                for (; mask; mask &= mask - 1)
+                {
+                    const size_t lane = static_cast<size_t>(std::countr_zero(mask));
+                    Verify(text, position + lane, lanes[lane], on_match, offset);
+                }
+            }
+            return position;
+        }
+#endif
+
+        /// Бор по классам байтов, затем переходы по суффиксным ссылкам (BFS) достраиваются до полного DFA
+        void BuildAhoCorasick()
+        {
+            _classes.fill(0);
+            for (const std::string& pattern : _patterns)
+                for (char c : pattern)
+                    _classes[static_cast<unsigned char>(c)] = 1;
+            _class_count = 1; // 0 - байты, которых нет ни в одной подстроке
+            for (uint8_t& value : _classes)
+                value = value ? static_cast<uint8_t>(_class_count++) : 0;
+
+            auto AddState = [this]()
+            {
+                _transitions.resize(_transitions.size() + _class_count, 0);
+                _first_pattern.push_back(-1);
+                _dictionary.push_back(-1);
+                return static_cast<uint32_t>(_first_pattern.size() - 1);
+            };
+            AddState();
+            _next_pattern.assign(_patterns.size(), -1);
+
+            constexpr uint32_t none = 0; // переход в корень внутри бора означает "нет ребра"
+            for (size_t pattern = 0; pattern < _patterns.size(); ++pattern)
+            {
+                uint32_t state = 0;
+                for (char c : _patterns[pattern])
+                {
+                    const size_t index = state * _class_count + _classes[static_cast<unsigned char>(c)];
+                    if (_transitions[index] == none)
+                    {
+                        const uint32_t next = AddState();
+                        _transitions[index] = next;
+                    }
+                    state = _transitions[index];
+                }
+                _next_pattern[pattern] = _first_pattern[state]; // одинаковые подстроки - список
+                _first_pattern[state] = static_cast<int32_t>(pattern);
+            }
+
+            std::vector<uint32_t> failure(_first_pattern.size(), 0);
+            std::queue<uint32_t> queue;
+            for (size_t c = 0; c < _class_count; ++c)
+                if (uint32_t next = _transitions[c]; next != none)
+                    queue.push(next);
+            while (!queue.empty())
+            {
+                const uint32_t state = queue.front();
+                queue.pop();
+                const uint32_t fail = failure[state];
+                _dictionary[state] = _first_pattern[fail] >= 0 ? static_cast<int32_t>(fail) : _dictionary[fail];
+                for (size_t c = 0; c < _class_count; ++c)
+                {
+                    uint32_t& next = _transitions[state * _class_count + c];
+                    const uint32_t fallback = _transitions[fail * _class_count + c];
+                    if (next != none)
+                    {
+                        failure[next] = fallback;
+                        queue.push(next);
+                    }
+                    else
+                        next = fallback;
+                }
+            }
+
+            // В таблице - сразу смещение строки состояния (без умножения на каждом байте) и флаг "здесь заканчивается подстрока"
+            for (uint32_t& next : _transitions)
+            {
+                const bool output = _first_pattern[next] >= 0 || _dictionary[next] >= 0;
+                next = static_cast<uint32_t>(next * _class_count) | (output ? output_flag : 0);
+            }
+        }
+
+        template<typename TCallback>
+        void AhoCorasick(std::string_view text, uint32_t& state, TCallback&& on_match, size_t offset) const
+        {
+            const uint32_t* transitions = _transitions.data();
+            const uint8_t* classes = _classes.data();
+            uint32_t current = state; // смещение строки состояния | output_flag
+            for (size_t i = 0; i < text.size(); ++i)
+            {
+                current = transitions[(current & ~output_flag) + classes[static_cast<unsigned char>(text[i])]];
+                if (!(current & output_flag))
+                    continue;
+                const size_t index = (current & ~output_flag) / _class_count;
+                int32_t output = _first_pattern[index] >= 0 ? static_cast<int32_t>(index) : _dictionary[index];
+                for (; output >= 0; output = _dictionary[static_cast<size_t>(output)])
+                    for (int32_t pattern = _first_pattern[static_cast<size_t>(output)]; pattern >= 0; pattern = _next_pattern[static_cast<size_t>(pattern)])
+                        on_match(Match{offset + i + 1 - _patterns[static_cast<size_t>(pattern)].size(), static_cast<size_t>(pattern)});
+            }
+            state = current;
+        }
+
+        std::vector<std::string> _patterns;
+        Engine _engine = Engine::Auto;
+        size_t _min_length = SIZE_MAX;
+        size_t _max_length = 0;
+
+        // Teddy
+        size_t _filter_length = 0;
+        std::array<std::vector<size_t>, buckets> _buckets;
+        std::array<std::array<uint8_t, 256>, 3> _byte_masks {};
+        std::array<std::array<uint8_t, 16>, 3> _low_masks {};
+        std::array<std::array<uint8_t, 16>, 3> _high_masks {};
+
+        // Aho-Corasick
+        std::array<uint8_t, 256> _classes {};
+        size_t _class_count = 0;
+        std::vector<uint32_t> _transitions;  // [состояние * _class_count + класс] -> следующее состояние * _class_count | output_flag
+        std::vector<int32_t> _first_pattern; // подстрока, заканчивающаяся в состоянии (-1 - нет)
+        std::vector<int32_t> _dictionary;    // ближайшее по суффиксным ссылкам состояние с подстрокой
+        std::vector<int32_t> _next_pattern;  // следующая такая же подстрока
+    };
+
+    /// Строки журнала: время, уровень, поток, сообщение
+    inline std::string MakeLog(size_t size)
+    {
+        static constexpr std::string_view levels[] = {"INFO", "INFO", "INFO", "DEBUG", "WARN", "ERROR"};
+        static constexpr std::string_view messages[] =
+        {
+            "request id=%", "took % ms", "connection refused", "cache miss key=%", "retry % of 5", "user % logged in",
+            "timeout after % ms", "queue size %", "GET /api/v1/items/%", "flush % bytes"
+        };
+        std::mt19937 generator(42);
+        std::string log;
+        log.reserve(size + 128);
+        while (log.size() < size)
+        {
+            log += "2024-05-01 12:";
+            log += std::to_string(10 + generator() % 50);
+            log += ' ';
+            log += levels[generator() % std::size(levels)];
+            log += " [worker-" + std::to_string(generator() % 8) + "] ";
+            for (char c : messages[generator() % std::size(messages)])
+                log += c == '%' ? std::to_string(generator() % 10000) : std::string(1, c);
+            log += '\n';
+        }
+        return log;
+    }
+}
+
+#endif /* MultiSearch_h */
@@ -0,0 +1,277 @@
+#ifndef PersonFile_h
+#define PersonFile_h
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/*
+ Бинарный формат файла с записями Person - чтение без разбора текста и без копирования:
+ | Header | Record[count] | куча строк (heap) |
+ Record фиксированного размера: age и смещение строк в куче. Строки одной записи лежат в куче подряд: name, city, country.
+ Writer пишет записи потоком в файл, а строки - во временный файл, который дописывается в конец при Close().
+ Reader отображает файл в память (mmap) и возвращает PersonView, поля которого - std::string_view на отображенную память.
+ Время загрузки = время открытия файла + подкачка страниц при первом обращении (page-in), разбора нет.
+ Порядок байт - порядок байт машины (little-endian на x86/ARM).
+ */
+
+namespace person_file
+{
+    struct LocationView
+    {
+        std::string_view city;
+        std::string_view country;
+    };
+
+    /// Person, поля которого ссылаются на отображенный файл: действительны, пока жив Reader
+    struct PersonView
+    {
+        std::string_view name;
+        uint32_t age;
+        LocationView loc;
+    };
+
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t record_size;
+        uint64_t count;
+        uint64_t heap_offset;
+        uint64_t heap_size;
+    };
+
+    struct Record
+    {
+        uint64_t offset; // смещение name в куче, city и country идут следом
+        uint32_t age;
+        uint32_t name_size;
+        uint32_t city_size;
+        uint32_t country_size;
+    };
+
+    static_assert(sizeof(Header) == 40);
+    static_assert(sizeof(Record) == 24);
+
+    inline constexpr char magic[8] = {'P', 'E', 'R', 'S', 'O', 'N', 'S', '\0'};
+    inline constexpr uint32_t version = 1;
+
+    class Writer
+    {
+    public:
+        explicit Writer(const std::filesystem::path& path) : _path(path), _heap_path(path.string() + ".heap")
+        {
+            _records.open(_path, std::ios::binary | std::ios::trunc);
+            _heap.open(_heap_path, std::ios::binary | std::ios::trunc);
+            if (!_records || !_heap)
+                throw std::runtime_error("person_file: cannot open " + _path.string());
+
+            Header header {};
+            _records.write(reinterpret_cast<const char*>(&header), sizeof(header)); // заполняется в Close()
+        }
+
+        Writer(const Writer&) = delete;
+        Writer& operator=(const Writer&) = delete;
+
+        ~Writer()
+        {
+            try
+            {
+                Close();
+            }
+            catch (...)
+            {
+            }
+        }
+
+        void Write(std::string_view name, uint32_t age, std::string_view city, std::string_view country)
+        {
+            Record record {_heap_size, age, static_cast<uint32_t>(name.size()), static_cast<uint32_t>(city.size()), static_cast<uint32_t>(country.size())};
+            _records.write(reinterpret_cast<const char*>(&record), sizeof(record));
+            _heap.write(name.data(), name.size());
+            _heap.write(city.data(), city.size());
+            _heap.write(country.data(), country.size());
+            _heap_size += name.size() + city.size() + country.size();
+            ++_count;
+        }
+
+        /// Любая структура с полями name, age, loc.city, loc.country (Person, PersonView)
+        template<typename TPerson>
+        void Write(const TPerson& person)
+        {
+            Write(person.name, person.age, person.loc.city, person.loc.country);
+        }
+
+        void Close()
+        {
+            if (!_records.is_open())
+                return;
+
+            _heap.close();
+            std::ifstream heap(_heap_path, std::ios::binary);
+            if (_heap_size)
+                _records << heap.rdbuf();
+            heap.close();
+            std::filesystem::remove(_heap_path);
+
+            Header header {};
+            std::memcpy(header.magic, magic, sizeof(magic));
+            header.version = version;
+            header.record_size = sizeof(Record);
+            header.count = _count;
+            header.heap_offset = sizeof(Header) + _count * sizeof(Record);
+            header.heap_size = _heap_size;
+            _records.seekp(0);
+            _records.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            _records.close();
+            if (!_records)
+                throw std::runtime_error("person_file: write failed " + _path.string());
+        }
+
+    private:
+        std::filesystem::path _path;
+        std::filesystem::path _heap_path;
+        std::ofstream _records;
+        std::ofstream _heap;
+        uint64_t _count = 0;
+        uint64_t _heap_size = 0;
+    };
+
+    class Reader
+    {
+    public:
+        /// prefetch - попросить ОС заранее подкачать весь файл (madvise WILLNEED)
+        explicit Reader(const std::filesystem::path& path, bool prefetch = false)
+        {
+#if defined(_WIN32)
+            _file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+            if (_file == INVALID_HANDLE_VALUE)
+                throw std::runtime_error("person_file: cannot open " + path.string());
+            LARGE_INTEGER size;
+            GetFileSizeEx(_file, &size);
+            _size = static_cast<size_t>(size.QuadPart);
+            if (_size)
+            {
+                _mapping = CreateFileMappingW(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+                _data = _mapping ? static_cast<const char*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+            }
+            (void)prefetch;
+#else
+            _file = open(path.c_str(), O_RDONLY);
+            if (_file < 0)
+                throw std::runtime_error("person_file: cannot open " + path.string());
+            struct stat info;
+            fstat(_file, &info);
+            _size = static_cast<size_t>(info.st_size);
+            if (_size)
+            {
+                void* data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, _file, 0);
+                _data = data == MAP_FAILED ? nullptr : static_cast<const char*>(data);
+                if (_data)
+                    madvise(const_cast<char*>(_data), _size, prefetch ? MADV_WILLNEED : MADV_NORMAL);
+            }
+#endif
+            if (!_data || _size < sizeof(Header))
+            {
+                Unmap();
+                throw std::runtime_error("person_file: cannot map " + path.string());
+            }
+
+            // Проверки без переполнения: count и размеры из файла не доверенные, count * sizeof(Record) может "обернуться" через 2^64
+            std::memcpy(&_header, _data, sizeof(Header));
+            if (std::memcmp(_header.magic, magic, sizeof(magic)) != 0 || _header.version != version || _header.record_size != sizeof(Record) ||
+                _header.count > (_size - sizeof(Header)) / sizeof(Record) || _header.heap_offset != sizeof(Header) + _header.count * sizeof(Record) ||
+                _header.heap_size > _size - _header.heap_offset)
+            {
+                Unmap();
+                throw std::runtime_error("person_file: invalid format " + path.string());
+            }
+            _records = reinterpret_cast<const Record*>(_data + sizeof(Header));
+            _heap = _data + _header.heap_offset;
+        }
+
+        Reader(const Reader&) = delete;
+        Reader& operator=(const Reader&) = delete;
+
+        ~Reader()
+        {
+            Unmap();
+        }
+
+        size_t size() const noexcept { return _header.count; }
+        bool empty() const noexcept { return _header.count == 0; }
+
+        /// Без проверки границ, как std::vector::operator[]
+        PersonView operator[](size_t index) const noexcept
+        {
+            const Record& record = _records[index];
+            const char* name = _heap + record.offset;
+            const char* city = name + record.name_size;
+            const char* country = city + record.city_size;
+            return {{name, record.name_size}, record.age, {{city, record.city_size}, {country, record.country_size}}};
+        }
+
+        PersonView at(size_t index) const
+        {
+            if (index >= size())
+                throw std::out_of_range("person_file::Reader::at");
+            const Record& record = _records[index];
+            const uint64_t sizes = uint64_t(record.name_size) + record.city_size + record.country_size; // три uint32_t не переполняют uint64_t
+            if (record.offset > _header.heap_size || sizes > _header.heap_size - record.offset)
+                throw std::out_of_range("person_file: record points outside of string heap");
+            return (*this)[index];
+        }
+
+    private:
+        void Unmap() noexcept
+        {
+#if defined(_WIN32)
+            if (_data)
+                UnmapViewOfFile(_data);
+            if (_mapping)
+                CloseHandle(_mapping);
+            if (_file != INVALID_HANDLE_VALUE)
+                CloseHandle(_file);
+            _mapping = nullptr;
+            _file = INVALID_HANDLE_VALUE;
+#else
+            if (_data)
+                munmap(const_cast<char*>(_data), _size);
+            if (_file >= 0)
+                close(_file);
+            _file = -1;
+#endif
+            _data = nullptr;
+        }
+
+#if defined(_WIN32)
+        HANDLE _file = INVALID_HANDLE_VALUE;
+        HANDLE _mapping = nullptr;
+#else
+        int _file = -1;
+#endif
+        const char* _data = nullptr;
+        size_t _size = 0;
+        Header _header {};
+        const Record* _records = nullptr;
+        const char* _heap = nullptr;
+    };
+}
+
+#endif /* PersonFile_h */
@@ -0,0 +1,558 @@
+#ifndef Pipeline_h
+#define Pipeline_h
+
+#include "StringView.h"
+
+#include <charconv>
+#include <cmath>
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+/*
+ Потоковый конвейер на корутинах C++20: чтение текста -> split (string_view, по пробельным символам) -> from_chars -> Sum/Average/Norm.
+ Слова, которые не разбираются как число целиком ("12abc"), пропускаются.
+ - Generator<T> - синхронный генератор (co_yield), стадия чтения: куски текста фиксированного размера
+ - Channel<T> - ограниченная очередь между стадиями: co_await Push() приостанавливает корутину, пока очередь полна (backpressure),
+   co_await Pop() - пока пуста. Приостановленная корутина не занимает поток: ее продолжит пул, когда появится место/данные.
+ - Task - корутина-стадия, которая запускается в ThreadPool; Wait() блокирует до ее завершения
+ Память ограничена: capacity кусков в каждом канале, независимо от размера входных данных.
+ */
+
+namespace pipeline
+{
+    class ThreadPool
+    {
+    public:
+        explicit ThreadPool(size_t threads = std::thread::hardware_concurrency())
+        {
+            for (size_t i = 0; i < std::max<size_t>(threads, 1); ++i)
+                _workers.emplace_back([this]() { Work(); });
+        }
+
+        ~ThreadPool()
+        {
+            {
+                std::lock_guard lock(_mutex);
+                _stop = true;
+            }
+            _condition.notify_all();
+            for (auto& worker : _workers)
+                worker.join();
+        }
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        void Schedule(std::coroutine_handle<> handle)
+        {
+            {
+                std::lock_guard lock(_mutex);
+                _queue.push_back(handle);
+            }
+            _condition.notify_one();
+        }
+
+    private:
+        void Work()
+        {
+            while (true)
+            {
+                std::coroutine_handle<> handle;
+                {
+                    std::unique_lock lock(_mutex);
+                    _condition.wait(lock, [this]() { return _stop || !_queue.empty(); });
+                    if (_queue.empty())
+                        return;
+                    handle = _queue.front();
+                    _queue.pop_front();
+                }
+                handle.resume();
+            }
+        }
+
+        std::mutex _mutex;
+        std::condition_variable _condition;
+        std::deque<std::coroutine_handle<>> _queue;
+        bool _stop = false;
+        std::vector<std::thread> _workers;
+    };
+
+    /// Стадия конвейера: создается приостановленной, Start(pool) запускает ее в пуле
+    class Task
+    {
+        struct State
+        {
+            std::mutex mutex;
+            std::condition_variable condition;
+            bool done = false;
+            std::exception_ptr exception;
+        };
+
+    public:
+        struct promise_type
+        {
+            std::shared_ptr<State> state = std::make_shared<State>();
+
+            Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this), state); }
+            std::suspend_always initial_suspend() noexcept { return {}; }
+
+            /// Кадр корутины удаляется сам (suspend_never), ожидающий узнает о завершении через State
+            std::suspend_never final_suspend() noexcept
+            {
+                {
+                    std::lock_guard lock(state->mutex);
+                    state->done = true;
+                }
+                state->condition.notify_all();
+                return {};
+            }
+
+            void return_void() noexcept {}
+            void unhandled_exception() noexcept { state->exception = std::current_exception(); }
+        };
+
+        Task(Task&& other) noexcept : _handle(std::exchange(other._handle, nullptr)), _state(std::move(other._state)) {}
+        Task(const Task&) = delete;
+        Task& operator=(const Task&) = delete;
+
+        ~Task()
+        {
+            if (_handle) // не запущена
+                _handle.destroy();
+        }
+
+        void Start(ThreadPool& pool)
+        {
+            pool.Schedule(std::exchange(_handle, nullptr));
+        }
+
+        /// Ожидание завершения, исключение из корутины пробрасывается
+        void Wait()
+        {
+            std::unique_lock lock(_state->mutex);
+            _state->condition.wait(lock, [this]() { return _state->done; });
+            if (_state->exception)
+                std::rethrow_exception(_state->exception);
+        }
+
+    private:
+        Task(std::coroutine_handle<promise_type> handle, std::shared_ptr<State> state) : _handle(handle), _state(std::move(state)) {}
+
+        std::coroutine_handle<promise_type> _handle;
+        std::shared_ptr<State> _state;
+    };
+
+    /// Синхронный генератор: for (auto& value : generator)
+    template<typename T>
+    class Generator
+    {
+    public:
+        struct promise_type
+        {
+            std::optional<T> value;
+            std::exception_ptr exception;
+
+            Generator get_return_object() { return Generator(std::coroutine_handle<promise_type>::from_promise(*this)); }
+            std::suspend_always initial_suspend() noexcept { return {}; }
+            std::suspend_always final_suspend() noexcept { return {}; }
+            std::suspend_always yield_value(T next)
+            {
+                value = std::move(next);
+                return {};
+            }
+            void return_void() noexcept {}
+            void unhandled_exception() noexcept { exception = std::current_exception(); }
+        };
+
+        class iterator
+        {
+        public:
+            explicit iterator(std::coroutine_handle<promise_type> handle) : _handle(handle) { Next(); }
+
+            T& operator*() const { return *_handle.promise().value; }
+            iterator& operator++()
+            {
+                Next();
+                return *this;
+            }
+            bool operator==(std::default_sentinel_t) const noexcept { return !_handle || _handle.done(); }
+
+        private:
+            void Next()
+            {
+                _handle.promise().value.reset();
+                _handle.resume();
+                if (_handle.promise().exception)
+                    std::rethrow_exception(_handle.promise().exception);
+            }
+
+            std::coroutine_handle<promise_type> _handle;
+        };
+
+        Generator(Generator&& other) noexcept : _handle(std::exchange(other._handle, nullptr)) {}
+        Generator(const Generator&) = delete;
+        Generator& operator=(const Generator&) = delete;
+
+        ~Generator()
+        {
+            if (_handle)
+                _handle.destroy();
+        }
+
+        iterator begin() { return iterator(_handle); }
+        std::default_sentinel_t end() const noexcept { return {}; }
+
+    private:
+        explicit Generator(std::coroutine_handle<promise_type> handle) : _handle(handle) {}
+
+        std::coroutine_handle<promise_type> _handle;
+    };
+
+    /// Ограниченный канал между стадиями. Ожидающие корутины продолжаются в пуле
+    template<typename T>
+    class Channel
+    {
+        struct Waiter
+        {
+            std::coroutine_handle<> handle;
+            std::optional<T>* value; // Push: откуда взять значение, Pop: куда положить
+            bool* ok;
+        };
+
+    public:
+        Channel(size_t capacity, ThreadPool& pool) : _capacity(std::max<size_t>(capacity, 1)), _pool(pool) {}
+
+        class PushAwaiter
+        {
+        public:
+            PushAwaiter(Channel& channel, T value) : _channel(channel), _value(std::move(value)) {}
+
+            bool await_ready() const noexcept { return false; }
+
+            /// false - продолжить без приостановки
+            bool await_suspend(std::coroutine_handle<> handle)
+            {
+                std::coroutine_handle<> wake;
+                {
+                    std::lock_guard lock(_channel._mutex);
+                    if (_channel._closed)
+                    {
+                        _ok = false;
+                        return false;
+                    }
+                    if (!_channel._pop_waiters.empty()) // значение сразу ожидающему Pop
+                    {
+                        Waiter waiter = _channel._pop_waiters.front();
+                        _channel._pop_waiters.pop_front();
+                        *waiter.value = std::move(_value);
+                        wake = waiter.handle;
+                    }
+                    else if (_channel._buffer.size() < _channel._capacity)
+                    {
+                        _channel._buffer.push_back(std::move(*_value));
+                    }
+                    else // очередь полна: ждем, пока Pop заберет значение
+                    {
+                        _channel._push_waiters.push_back(Waiter {handle, &_value, &_ok});
+                        return true;
+                    }
+                }
+                if (wake)
+                    _channel._pool.Schedule(wake);
+                return false;
+            }
+
+            /// false - канал закрыт, значение не доставлено
+            bool await_resume() const noexcept { return _ok; }
+
+        private:
+            Channel& _channel;
+            std::optional<T> _value;
+            bool _ok = true;
+        };
+
+        class PopAwaiter
+        {
+        public:
+            explicit PopAwaiter(Channel& channel) : _channel(channel) {}
+
+            bool await_ready() const noexcept { return false; }
+
+            bool await_suspend(std::coroutine_handle<> handle)
+            {
+                std::coroutine_handle<> wake;
+                {
+                    std::lock_guard lock(_channel._mutex);
+                    if (!_channel._buffer.empty())
+                    {
+                        _value = std::move(_channel._buffer.front());
+                        _channel._buffer.pop_front();
+                        if (!_channel._push_waiters.empty()) // освободилось место: значение ожидающего Push в очередь
+                        {
+                            Waiter waiter = _channel._push_waiters.front();
+                            _channel._push_waiters.pop_front();
+                            _channel._buffer.push_back(std::move(**waiter.value));
+                            wake = waiter.handle;
+                        }
+                    }
+                    else if (!_channel._closed)
+                    {
+                        _channel._pop_waiters.push_back(Waiter {handle, &_value, &_ok});
+                        return true;
+                    }
+                }
+                if (wake)
+                    _channel._pool.Schedule(wake);
+                return false;
+            }
+
+            /// std::nullopt - канал закрыт и пуст
+            std::optional<T> await_resume() noexcept { return std::move(_value); }
+
+        private:
+            Channel& _channel;
+            std::optional<T> _value;
+            bool _ok = true;
+        };
+
+        [[nodiscard]] PushAwaiter Push(T value) { return PushAwaiter(*this, std::move(value)); }
+        [[nodiscard]] PopAwaiter Pop() { return PopAwaiter(*this); }
+
+        /// Больше значений не будет: ожидающие Pop получают std::nullopt, ожидающие Push - false
+        void Close()
+        {
+            std::deque<Waiter> waiters;
+            {
+                std::lock_guard lock(_mutex);
+                _closed = true;
+                waiters.swap(_pop_waiters);
+                for (Waiter& waiter : _push_waiters)
+                {
+                    *waiter.ok = false;
+                    waiters.push_back(waiter);
+                }
+                _push_waiters.clear();
+            }
+            for (Waiter& waiter : waiters)
+                _pool.Schedule(waiter.handle);
+        }
+
+    private:
+        const size_t _capacity;
+        ThreadPool& _pool;
+
+        std::mutex _mutex;
+        std::deque<T> _buffer;
+        std::deque<Waiter> _push_waiters;
+        std::deque<Waiter> _pop_waiters;
+        bool _closed = false;
+    };
+
+    /// Инкрементальные Sum/Average/Norm (как fold_expression::Sum/Average/Norm, но по потоку чисел)
+    struct Aggregate
+    {
+        double sum = 0;
+        double sum_squares = 0;
+        size_t count = 0;
+
+        void Add(double number) noexcept
+        {
+            sum += number;
+            sum_squares += number * number;
+            ++count;
+        }
+
+        double Sum() const noexcept { return sum; }
+        double Average() const noexcept { return count ? sum / static_cast<double>(count) : 0; }
+        double Norm() const noexcept { return std::sqrt(sum_squares); }
+    };
+
+    struct Options
+    {
+        size_t chunk_size = 64 * 1024; // байт текста в одном куске
+        size_t capacity = 4;           // кусков в каждом канале
+    };
+
+    /// Разделители слов - пробельные символы, как у std::isspace в локали "C"
+    inline constexpr std::string_view whitespace = " \t\n\v\f\r";
+
+    /// Число, только если слово разобрано целиком: "12abc" - не число
+    inline std::optional<double> ParseNumber(std::string_view word) noexcept
+    {
+        double number = 0;
+        auto [end, error] = std::from_chars(word.data(), word.data() + word.size(), number);
+        if (error != std::errc() || end != word.data() + word.size())
+            return std::nullopt;
+        return number;
+    }
+
+    /// Куски текста, заканчивающиеся разделителем (кроме последнего): слово не разрывается между кусками
+    inline Generator<std::unique_ptr<std::string>> ReadChunks(std::istream& in, size_t chunk_size, std::string_view delimiters = whitespace)
+    {
+        std::string rest;
+        while (in)
+        {
+            auto chunk = std::make_unique<std::string>(std::move(rest));
+            size_t size = chunk->size();
+            chunk->resize(size + chunk_size);
+            in.read(chunk->data() + size, static_cast<std::streamsize>(chunk_size));
+            chunk->resize(size + static_cast<size_t>(in.gcount()));
+
+            if (in)
+            {
+                size_t last = chunk->find_last_of(delimiters);
+                if (last == std::string::npos) // слово длиннее куска: читаем дальше
+                {
+                    rest = std::move(*chunk);
+                    continue;
+                }
+                rest.assign(*chunk, last + 1);
+                chunk->resize(last + 1);
+            }
+            if (!chunk->empty())
+                co_yield std::move(chunk);
+        }
+    }
+
+    /// Закрывает каналы стадии при выходе из корутины (в том числе по исключению): соседние стадии не зависнут в Push/Pop
+    template<typename... TChannels>
+    class Closer
+    {
+    public:
+        explicit Closer(TChannels&... channels) : _channels(channels...) {}
+        ~Closer()
+        {
+            std::apply([](auto&... channels) { (channels.Close(), ...); }, _channels);
+        }
+
+        Closer(const Closer&) = delete;
+        Closer& operator=(const Closer&) = delete;
+
+    private:
+        std::tuple<TChannels&...> _channels;
+    };
+
+    /// Слова ссылаются на текст куска, поэтому передаются вместе с ним
+    struct Tokens
+    {
+        std::unique_ptr<std::string> text;
+        std::vector<std::string_view> words;
+    };
+
+    inline Task Read(std::istream& in, Options options, Channel<std::unique_ptr<std::string>>& output)
+    {
+        Closer close(output);
+        for (auto& chunk : ReadChunks(in, options.chunk_size))
+        {
+            if (!co_await output.Push(std::move(chunk)))
+                break;
+        }
+    }
+
+    inline Task Tokenize(Channel<std::unique_ptr<std::string>>& input, Channel<Tokens>& output)
+    {
+        Closer close(input, output);
+        while (auto chunk = co_await input.Pop())
+        {
+            Tokens tokens {std::move(*chunk), {}};
+            STRING_VIEW::split_words(std::string_view(*tokens.text), tokens.words, whitespace); // срезы string_view, без копий слов
+            if (!co_await output.Push(std::move(tokens)))
+                break;
+        }
+    }
+
+    inline Task Parse(Channel<Tokens>& input, Channel<std::vector<double>>& output)
+    {
+        Closer close(input, output);
+        while (auto tokens = co_await input.Pop())
+        {
+            std::vector<double> numbers;
+            numbers.reserve(tokens->words.size());
+            for (std::string_view word : tokens->words)
+                if (auto number = ParseNumber(word))
+                    numbers.push_back(*number);
+            if (!co_await output.Push(std::move(numbers)))
+                break;
+        }
+    }
+
+    inline Task Reduce(Channel<std::vector<double>>& input, Aggregate& aggregate, std::function<void(const Aggregate&)> progress)
+    {
+        Closer close(input);
+        while (auto numbers = co_await input.Pop())
+        {
+            for (double number : *numbers)
+                aggregate.Add(number);
+            if (progress)
+                progress(aggregate);
+        }
+    }
+
+    /// Конвейер целиком: 4 стадии в пуле, progress вызывается после каждого куска с промежуточным результатом
+    inline Aggregate Run(std::istream& in, ThreadPool& pool, Options options = Options(), std::function<void(const Aggregate&)> progress = nullptr)
+    {
+        Channel<std::unique_ptr<std::string>> chunks(options.capacity, pool);
+        Channel<Tokens> tokens(options.capacity, pool);
+        Channel<std::vector<double>> numbers(options.capacity, pool);
+        Aggregate aggregate;
+
+        Task tasks[] = {Read(in, options, chunks), Tokenize(chunks, tokens), Parse(tokens, numbers), Reduce(numbers, aggregate, std::move(progress))};
+        for (Task& task : tasks)
+            task.Start(pool);
+
+        // Ждем все стадии, даже если одна завершилась исключением: остальные еще используют каналы и aggregate этого кадра
+        std::exception_ptr error;
+        for (Task& task : tasks)
+        {
+            try
+            {
+                task.Wait();
+            }
+            catch (...)
+            {
+                if (!error)
+                    error = std::current_exception();
+            }
+        }
+        if (error)
+            std::rethrow_exception(error);
+        return aggregate;
+    }
+
+    /// Материализация всего сразу: весь текст, все слова, все числа в памяти, затем подсчет
+    inline Aggregate RunMaterialized(std::istream& in)
+    {
+        std::ostringstream buffer;
+        buffer << in.rdbuf();
+        std::string text = std::move(buffer).str();
+
+        std::vector<std::string_view> words;
+        STRING_VIEW::split_words(std::string_view(text), words, whitespace);
+        std::vector<double> numbers;
+        numbers.reserve(words.size());
+        for (std::string_view word : words)
+            if (auto number = ParseNumber(word))
+                numbers.push_back(*number);
+
+        Aggregate aggregate;
+        for (double number : numbers)
+            aggregate.Add(number);
+        return aggregate;
+    }
+}
+
+#endif /* Pipeline_h */
@@ -0,0 +1,440 @@
+#ifndef RadixSort_h
+#define RadixSort_h
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <concepts>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/*
+ Сортировка больших массивов записей (Person) по целому ключу (age), затем по строке (name), без перемещения самих записей.
+ std::sort на vector<Person> при каждом обмене перемещает всю запись с тремя строками, а сравнение (age, name) ходит по указателям строк.
+ Здесь сортируются пары (ключ, индекс) по 8-16 байт, а записи переставляются один раз в конце (Permute) или не переставляются вовсе.
+ - LSD (least significant digit) по байтам ключа: устойчиво, O(n * sizeof(key)), проходы с одинаковым байтом у всех ключей пропускаются
+   (возраст < 256 - один проход). Параллельно: каждый поток считает гистограмму своей части, смещения (цифра, поток) складываются
+   по порядку потоков, и каждый поток раскладывает свою часть - результат тот же, что в одном потоке.
+ - MSD (most significant digit) по символам строки: корзины по символу на глубине depth, общий префикс пропускается без перестановки,
+   маленькие корзины - сортировка вставками. Тоже устойчиво.
+ - Ключ, затем строка: LSD по ключу, затем MSD внутри каждой группы равных ключей (группы - параллельно).
+ - Top-K: порог ключа выбирается по разрядам (radix select) за один проход гистограммы на значимый байт, полностью сортируются
+   только записи с ключом меньше порога, а группа с ключом, равным порогу, - частично (std::partial_sort по имени).
+ Индексы - uint32_t (до 2^32 записей). Равные (ключ, строка) остаются в исходном порядке, как у std::stable_sort.
+ */
+
+namespace radix
+{
+    using Index = uint32_t;
+
+    namespace detail
+    {
+        /// Беззнаковый ключ с тем же порядком: у знаковых инвертируется знаковый бит
+        template<std::integral TKey>
+        requires (!std::same_as<TKey, bool>)
+        constexpr auto Encode(TKey key) noexcept
+        {
+            using Unsigned = std::make_unsigned_t<TKey>;
+            if constexpr (std::is_signed_v<TKey>)
+                return static_cast<Unsigned>(static_cast<Unsigned>(key) ^ (Unsigned(1) << (sizeof(TKey) * 8 - 1)));
+            else
+                return key;
+        }
+
+        template<typename T, typename TKey>
+        using EncodedKey = decltype(Encode(std::declval<std::remove_cvref_t<std::invoke_result_t<TKey&, const T&>>>()));
+
+        template<typename TKey>
+        struct Entry
+        {
+            TKey key;
+            Index index;
+        };
+
+        struct StringEntry
+        {
+            std::string_view key;
+            Index index;
+        };
+
+        /// Меньше - один поток: запуск потока дороже сортировки такой части
+        inline constexpr size_t parallel_threshold = 1 << 16;
+        /// Корзины меньше - сортировка вставками
+        inline constexpr size_t insertion_threshold = 32;
+
+        inline size_t Threads(size_t size, size_t threads) noexcept
+        {
+            return std::max<size_t>(1, std::min(threads, size / parallel_threshold));
+        }
+
+        /// Начало части thread из threads равных частей [0, size)
+        inline size_t Chunk(size_t size, size_t thread, size_t threads) noexcept
+        {
+            return size * thread / threads;
+        }
+
+        /// function(thread) в threads потоках, поток 0 - вызывающий
+        template<typename TFunction>
+        void ParallelFor(size_t threads, TFunction&& function)
+        {
+            if (threads <= 1)
+            {
+                function(size_t(0));
+                return;
+            }
+            std::vector<std::jthread> workers;
+            workers.reserve(threads - 1);
+            for (size_t thread = 1; thread < threads; ++thread)
+                workers.emplace_back([&function, thread]() { function(thread); });
+            function(size_t(0));
+        }
+
+        inline void CheckSize(size_t size)
+        {
+            if (size > std::numeric_limits<Index>::max())
+                throw std::invalid_argument("radix: больше 2^32 элементов");
+        }
+
+        /// (ключ, индекс) всех элементов
+        template<typename T, typename TKey>
+        auto MakeEntries(const std::vector<T>& items, TKey& key, size_t threads)
+        {
+            CheckSize(items.size());
+            std::vector<Entry<EncodedKey<T, TKey>>> entries(items.size());
+            ParallelFor(threads, [&](size_t thread)
+            {
+                for (size_t i = Chunk(items.size(), thread, threads), end = Chunk(items.size(), thread + 1, threads); i < end; ++i)
+                    entries[i] = {Encode(std::invoke(key, items[i])), static_cast<Index>(i)};
+            });
+            return entries;
+        }
+
+        /// LSD по байтам ключа: устойчиво
+        template<typename TKey>
+        void LsdSort(std::vector<Entry<TKey>>& entries, size_t threads)
+        {
+            const size_t size = entries.size();
+            threads = Threads(size, threads);
+
+            auto buffer = std::make_unique_for_overwrite<Entry<TKey>[]>(size);
+            Entry<TKey>* source = entries.data();
+            Entry<TKey>* destination = buffer.get();
+            std::vector<std::array<size_t, 256>> counts(threads);
+
+            for (size_t shift = 0; shift < sizeof(TKey) * 8; shift += 8)
+            {
+                ParallelFor(threads, [&](size_t thread)
+                {
+                    auto& count = counts[thread];
+                    count.fill(0);
+                    for (size_t i = Chunk(size, thread, threads), end = Chunk(size, thread + 1, threads); i < end; ++i)
+                        ++count[(source[i].key >> shift) & 0xFF];
+                });
+
+                // смещение (цифра, поток): все меньшие цифры, затем та же цифра в предыдущих потоках - порядок сохраняется
+                bool single = false;
+                size_t offset = 0;
+                for (size_t digit = 0; digit < 256; ++digit)
+                {
+                    const size_t start = offset;
+                    for (auto& count : counts)
+                        offset += std::exchange(count[digit], offset);
+                    single |= offset - start == size;
+                }
+                if (single)
+                    continue; // у всех ключей одинаковый байт
+
+                ParallelFor(threads, [&](size_t thread)
+                {
+                    auto& position = counts[thread];
+                    for (size_t i = Chunk(size, thread, threads), end = Chunk(size, thread + 1, threads); i < end; ++i)
+                    {
+                        const Entry<TKey> entry = source[i];
+                        destination[position[(entry.key >> shift) & 0xFF]++] = entry;
+                    }
+                });
+                std::swap(source, destination);
+            }
+            if (source != entries.data())
+                std::copy(source, source + size, entries.data());
+        }
+
+        /// Символ на глубине depth: 0 - строка закончилась (такие строки меньше всех), иначе 1 + байт
+        inline size_t Digit(std::string_view key, size_t depth) noexcept
+        {
+            return depth < key.size() ? 1 + static_cast<unsigned char>(key[depth]) : 0;
+        }
+
+        /// Устойчивая сортировка вставками по суффиксам с глубины depth (короче depth строк в корзине нет)
+        inline void InsertionSort(StringEntry* entries, size_t size, size_t depth) noexcept
+        {
+            for (size_t i = 1; i < size; ++i)
+            {
+                const StringEntry entry = entries[i];
+                const std::string_view suffix = entry.key.substr(depth);
+                size_t j = i;
+                for (; j > 0 && suffix < entries[j - 1].key.substr(depth); --j)
+                    entries[j] = entries[j - 1];
+                entries[j] = entry;
+            }
+        }
+
+        /*
+         Раскладывает entries по корзинам символа на глубине depth: корзина d - [bounds[d], bounds[d + 1]).
+         Общий префикс пропускается (depth увеличивается) без перестановки. false - все строки равны, сортировать нечего.
+         */
+        inline bool Distribute(StringEntry* entries, StringEntry* buffer, size_t size, size_t& depth, std::array<size_t, 258>& bounds) noexcept
+        {
+            std::array<size_t, 257> count;
+            while (true)
+            {
+                count.fill(0);
+                for (size_t i = 0; i < size; ++i)
+                    ++count[Digit(entries[i].key, depth)];
+                if (count[0] == size)
+                    return false;
+                if (count[Digit(entries[0].key, depth)] != size)
+                    break;
+                ++depth;
+            }
+
+            bounds[0] = 0;
+            for (size_t digit = 0; digit < 257; ++digit)
+                bounds[digit + 1] = bounds[digit] + count[digit];
+            std::copy(bounds.begin(), bounds.end() - 1, count.begin());
+            for (size_t i = 0; i < size; ++i)
+                buffer[count[Digit(entries[i].key, depth)]++] = entries[i];
+            std::copy(buffer, buffer + size, entries);
+            return true;
+        }
+
+        /// MSD по символам: buffer - временная память того же размера
+        inline void MsdSort(StringEntry* entries, StringEntry* buffer, size_t size, size_t depth) noexcept
+        {
+            if (size < insertion_threshold)
+            {
+                InsertionSort(entries, size, depth);
+                return;
+            }
+            std::array<size_t, 258> bounds;
+            if (!Distribute(entries, buffer, size, depth, bounds))
+                return;
+            for (size_t digit = 1; digit < 257; ++digit) // корзина 0 - строки длины depth, они равны
+                if (size_t count = bounds[digit + 1] - bounds[digit]; count > 1)
+                    MsdSort(entries + bounds[digit], buffer + bounds[digit], count, depth + 1);
+        }
+
+        /// Первое разделение - в вызывающем потоке, корзины - параллельно
+        inline void ParallelMsdSort(StringEntry* entries, StringEntry* buffer, size_t size, size_t threads)
+        {
+            threads = Threads(size, threads);
+            if (threads == 1)
+            {
+                MsdSort(entries, buffer, size, 0);
+                return;
+            }
+            size_t depth = 0;
+            std::array<size_t, 258> bounds;
+            if (!Distribute(entries, buffer, size, depth, bounds))
+                return;
+            std::atomic<size_t> next = 1;
+            ParallelFor(threads, [&](size_t)
+            {
+                for (size_t digit; (digit = next.fetch_add(1, std::memory_order_relaxed)) < 257;)
+                    if (size_t count = bounds[digit + 1] - bounds[digit]; count > 1)
+                        MsdSort(entries + bounds[digit], buffer + bounds[digit], count, depth + 1);
+            });
+        }
+
+        template<typename T, typename TName>
+        void CheckName()
+        {
+            using Result = std::invoke_result_t<TName&, const T&>;
+            static_assert(std::is_convertible_v<Result, std::string_view>, "radix: name должен возвращать строку");
+            static_assert(std::is_reference_v<Result> || !std::is_same_v<std::remove_cvref_t<Result>, std::string>,
+                          "radix: name должен возвращать ссылку на строку или string_view, а не временную std::string");
+        }
+
+        /// entries уже упорядочены по ключу: группы равных ключей сортируются по name, результат - индексы
+        template<typename T, typename TName, typename TKey>
+        std::vector<Index> SortGroupsByName(const std::vector<T>& items, TName& name, const std::vector<Entry<TKey>>& entries, size_t threads)
+        {
+            const size_t size = entries.size();
+            threads = Threads(size, threads);
+
+            std::vector<StringEntry> strings(size);
+            ParallelFor(threads, [&](size_t thread)
+            {
+                for (size_t i = Chunk(size, thread, threads), end = Chunk(size, thread + 1, threads); i < end; ++i)
+                    strings[i] = {std::invoke(name, items[entries[i].index]), entries[i].index};
+            });
+
+            std::vector<std::pair<size_t, size_t>> groups;
+            for (size_t begin = 0, end; begin < size; begin = end)
+            {
+                for (end = begin + 1; end < size && entries[end].key == entries[begin].key; ++end) {}
+                if (end - begin > 1)
+                    groups.emplace_back(begin, end);
+            }
+
+            auto buffer = std::make_unique_for_overwrite<StringEntry[]>(size);
+            if (groups.size() == 1)
+                ParallelMsdSort(strings.data() + groups[0].first, buffer.get() + groups[0].first, groups[0].second - groups[0].first, threads);
+            else
+            {
+                std::atomic<size_t> next = 0;
+                ParallelFor(threads, [&](size_t)
+                {
+                    for (size_t group; (group = next.fetch_add(1, std::memory_order_relaxed)) < groups.size();)
+                    {
+                        auto [begin, end] = groups[group];
+                        MsdSort(strings.data() + begin, buffer.get() + begin, end - begin, 0);
+                    }
+                });
+            }
+
+            std::vector<Index> result(size);
+            for (size_t i = 0; i < size; ++i)
+                result[i] = strings[i].index;
+            return result;
+        }
+    }
+
+    /// Индексы items в порядке возрастания key(item), равные - в исходном порядке
+    template<typename T, typename TKey>
+    requires std::integral<std::remove_cvref_t<std::invoke_result_t<TKey&, const T&>>>
+    std::vector<Index> SortIndices(const std::vector<T>& items, TKey key, size_t threads = std::thread::hardware_concurrency())
+    {
+        auto entries = detail::MakeEntries(items, key, detail::Threads(items.size(), threads));
+        detail::LsdSort(entries, threads);
+
+        std::vector<Index> result(entries.size());
+        for (size_t i = 0; i < entries.size(); ++i)
+            result[i] = entries[i].index;
+        return result;
+    }
+
+    /// Индексы items в порядке возрастания строки name(item) (побайтово, как std::string_view::compare)
+    template<typename T, typename TName>
+    std::vector<Index> SortIndicesByString(const std::vector<T>& items, TName name, size_t threads = std::thread::hardware_concurrency())
+    {
+        detail::CheckName<T, TName>();
+        detail::CheckSize(items.size());
+
+        std::vector<detail::StringEntry> strings(items.size());
+        for (size_t i = 0; i < items.size(); ++i)
+            strings[i] = {std::invoke(name, items[i]), static_cast<Index>(i)};
+        auto buffer = std::make_unique_for_overwrite<detail::StringEntry[]>(items.size());
+        detail::ParallelMsdSort(strings.data(), buffer.get(), strings.size(), threads);
+
+        std::vector<Index> result(strings.size());
+        for (size_t i = 0; i < strings.size(); ++i)
+            result[i] = strings[i].index;
+        return result;
+    }
+
+    /// Индексы items в порядке возрастания (key(item), name(item))
+    template<typename T, typename TKey, typename TName>
+    requires std::integral<std::remove_cvref_t<std::invoke_result_t<TKey&, const T&>>>
+    std::vector<Index> SortIndices(const std::vector<T>& items, TKey key, TName name, size_t threads = std::thread::hardware_concurrency())
+    {
+        detail::CheckName<T, TName>();
+        auto entries = detail::MakeEntries(items, key, detail::Threads(items.size(), threads));
+        detail::LsdSort(entries, threads);
+        return detail::SortGroupsByName(items, name, entries, threads);
+    }
+
+    /// Первые min(k, size) индексов порядка SortIndices(items, key, name) без сортировки остальных
+    template<typename T, typename TKey, typename TName>
+    requires std::integral<std::remove_cvref_t<std::invoke_result_t<TKey&, const T&>>>
+    std::vector<Index> TopK(const std::vector<T>& items, size_t k, TKey key, TName name, size_t threads = std::thread::hardware_concurrency())
+    {
+        detail::CheckName<T, TName>();
+        k = std::min(k, items.size());
+        if (k == 0)
+            return {};
+
+        // ключи один раз в плотный массив: проходы по нему дешевле проходов по записям
+        const auto entries = detail::MakeEntries(items, key, detail::Threads(items.size(), threads));
+        using Key = detail::EncodedKey<T, TKey>;
+        constexpr int bits = static_cast<int>(sizeof(Key) * 8);
+
+        // radix select: threshold - k-й по возрастанию ключ, below - число ключей меньше threshold.
+        // Все ключи лежат в [min, max], поэтому старшие байты, общие у min и max, общие у всех ключей - по ним гистограмма не нужна
+        Key min = entries[0].key, max = min;
+        for (const auto& entry : entries)
+        {
+            min = std::min(min, entry.key);
+            max = std::max(max, entry.key);
+        }
+        const Key different = static_cast<Key>(min ^ max);
+        Key threshold = 0;
+        size_t below = 0;
+        for (int shift = bits - 8; shift >= 0; shift -= 8)
+        {
+            const Key byte = static_cast<Key>(Key(0xFF) << shift);
+            if ((different >> shift) == 0)
+            {
+                threshold |= static_cast<Key>(min & byte);
+                continue;
+            }
+            // гистограмма байта среди ключей, у которых старшие байты равны старшим байтам порога
+            const Key high = shift + 8 < bits ? static_cast<Key>(~Key(0) << (shift + 8)) : Key(0);
+            std::array<size_t, 256> count {};
+            for (const auto& entry : entries)
+                if ((entry.key & high) == (threshold & high))
+                    ++count[(entry.key >> shift) & 0xFF];
+            size_t digit = 0;
+            for (; below + count[digit] < k; ++digit)
+                below += count[digit];
+            threshold |= static_cast<Key>(Key(digit) << shift);
+        }
+
+        // меньше порога - полная сортировка, равные порогу - только нужное число по имени
+        std::vector<detail::Entry<Key>> less;
+        std::vector<detail::StringEntry> equal;
+        less.reserve(below);
+        for (const auto& entry : entries)
+        {
+            if (entry.key < threshold)
+                less.push_back(entry);
+            else if (entry.key == threshold)
+                equal.push_back({std::invoke(name, items[entry.index]), entry.index});
+        }
+        detail::LsdSort(less, threads);
+        std::vector<Index> result = detail::SortGroupsByName(items, name, less, threads);
+
+        const size_t rest = k - below;
+        std::partial_sort(equal.begin(), equal.begin() + static_cast<std::ptrdiff_t>(rest), equal.end(), [](const auto& left, const auto& right)
+        {
+            return left.key != right.key ? left.key < right.key : left.index < right.index;
+        });
+        for (size_t i = 0; i < rest; ++i)
+            result.push_back(equal[i].index);
+        return result;
+    }
+
+    /// Переставляет items в порядок order (order[i] - индекс элемента, который станет i-м): каждый элемент перемещается один раз
+    template<typename T>
+    void Permute(std::vector<T>& items, const std::vector<Index>& order)
+    {
+        if (order.size() != items.size())
+            throw std::invalid_argument("radix::Permute: размер order не совпадает с размером items");
+        std::vector<T> result;
+        result.reserve(items.size());
+        for (Index index : order)
+            result.push_back(std::move(items[index]));
+        items = std::move(result);
+    }
+}
+
+#endif /* RadixSort_h */
@@ -0,0 +1,316 @@
+#ifndef Reflection_h
+#define Reflection_h
+
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/*
+ Рефлексия агрегатов (struct без конструкторов, приватных полей и базовых классов) без макросов:
+ 1. Количество полей: пробуем инициализировать T{Any, Any, ...}, где Any приводится к любому типу. Максимальное число аргументов, при котором инициализация компилируется, - число полей.
+ 2. Доступ к полям: декомпозиция (structured bindings) auto& [a, b, c] = object для известного числа полей.
+ Ограничение: не больше 12 полей, вложенные агрегаты (Person::loc) обходятся рекурсивно.
+ Поля - C-массивы не поддерживаются: T{Any, ...} инициализирует элементы массива по одному (brace elision), и field_count для struct {int a[3]; int b;} - 4, а не 2.
+ Tie, ForEachField и Serialize для такого типа не компилируются (число имен в декомпозиции не совпадает с числом полей); вместо массива - std::array.
+
+ Бинарная сериализация:
+ - целые числа - varint (по 7 бит в байте, старший бит - признак продолжения), знаковые - zigzag (0, -1, 1, -2 -> 0, 1, 2, 3)
+ - строки - длина (varint) + байты, std::string_view при чтении ссылается на входной буфер без копирования (zero-copy)
+ - числа с плавающей запятой - байты как есть
+ - агрегаты - поля подряд, std::vector - длина + элементы
+ Чтение возвращает std::from_chars_result как std::from_chars: указатель на конец прочитанного и std::errc при ошибке,
+ число, которое не помещается в тип поля, - std::errc::result_out_of_range (как у std::from_chars).
+ */
+
+namespace reflection
+{
+    /// Приводится к любому типу - только для проверки инициализации в невычисляемом контексте
+    struct Any
+    {
+        template<typename T>
+        operator T() const;
+    };
+
+    template<typename T, typename... Args>
+    consteval size_t FieldCount()
+    {
+        if constexpr (requires { T{std::declval<Args>()..., std::declval<Any>()}; })
+            return FieldCount<T, Args..., Any>();
+        else
+            return sizeof...(Args);
+    }
+
+    /// Число полей агрегата: для полей - C-массивов больше настоящего (каждый элемент считается отдельно)
+    template<typename T>
+    inline constexpr size_t field_count = FieldCount<std::remove_cvref_t<T>>();
+
+    template<typename T>
+    concept Aggregate = std::is_aggregate_v<std::remove_cvref_t<T>> && !std::is_array_v<std::remove_cvref_t<T>>;
+
+    /// Кортеж ссылок на поля агрегата
+    template<Aggregate T>
+    constexpr auto Tie(T& object) noexcept
+    {
+        constexpr size_t count = field_count<T>;
+        static_assert(count <= 12, "reflection: more than 12 fields is not supported");
+
+        if constexpr (count == 0)
+            return std::tie();
+        else if constexpr (count == 1)
+        {
+            auto& [a] = object;
+            return std::tie(a);
+        }
+        else if constexpr (count == 2)
+        {
+            auto& [a, b] = object;
+            return std::tie(a, b);
+        }
+        else if constexpr (count == 3)
+        {
+            auto& [a, b, c] = object;
+            return std::tie(a, b, c);
+        }
+        else if constexpr (count == 4)
+        {
+            auto& [a, b, c, d] = object;
+            return std::tie(a, b, c, d);
+        }
+        else if constexpr (count == 5)
+        {
+            auto& [a, b, c, d, e] = object;
+            return std::tie(a, b, c, d, e);
+        }
+        else if constexpr (count == 6)
+        {
+            auto& [a, b, c, d, e, f] = object;
+            return std::tie(a, b, c, d, e, f);
+        }
+        else if constexpr (count == 7)
+        {
+            auto& [a, b, c, d, e, f, g] = object;
+            return std::tie(a, b, c, d, e, f, g);
+        }
+        else if constexpr (count == 8)
+        {
+            auto& [a, b, c, d, e, f, g, h] = object;
+            return std::tie(a, b, c, d, e, f, g, h);
+        }
+        else if constexpr (count == 9)
+        {
+            auto& [a, b, c, d, e, f, g, h, i] = object;
+            return std::tie(a, b, c, d, e, f, g, h, i);
+        }
+        else if constexpr (count == 10)
+        {
+            auto& [a, b, c, d, e, f, g, h, i, j] = object;
+            return std::tie(a, b, c, d, e, f, g, h, i, j);
+        }
+        else if constexpr (count == 11)
+        {
+            auto& [a, b, c, d, e, f, g, h, i, j, k] = object;
+            return std::tie(a, b, c, d, e, f, g, h, i, j, k);
+        }
+        else
+        {
+            auto& [a, b, c, d, e, f, g, h, i, j, k, l] = object;
+            return std::tie(a, b, c, d, e, f, g, h, i, j, k, l);
+        }
+    }
+
+    /// Вызов function для каждого поля агрегата (fold expression по кортежу ссылок)
+    template<Aggregate T, typename TFunction>
+    constexpr void ForEachField(T& object, TFunction&& function)
+    {
+        std::apply([&](auto&... fields) { (function(fields), ...); }, Tie(object));
+    }
+
+    template<typename T>
+    struct is_vector : std::false_type {};
+
+    template<typename T, typename TAllocator>
+    struct is_vector<std::vector<T, TAllocator>> : std::true_type {};
+
+    /// Запись varint: по 7 бит, старший бит - есть продолжение
+    inline void WriteVarint(std::string& out, uint64_t value)
+    {
+        char buffer[10];
+        size_t size = 0;
+        while (value >= 0x80)
+        {
+            buffer[size++] = static_cast<char>(value | 0x80);
+            value >>= 7;
+        }
+        buffer[size++] = static_cast<char>(value);
+        out.append(buffer, size);
+    }
+
+    inline std::from_chars_result ReadVarint(const char* first, const char* last, uint64_t& value)
+    {
+        value = 0;
+        for (unsigned shift = 0; shift < 64; shift += 7)
+        {
+            if (first == last)
+                return {first, std::errc::invalid_argument};
+
+            auto byte = static_cast<uint8_t>(*first++);
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80))
+                return {first, std::errc()};
+        }
+        return {first, std::errc::value_too_large};
+    }
+
+    template<typename T>
+    void Serialize(const T& value, std::string& out)
+    {
+        if constexpr (std::is_same_v<T, bool>)
+        {
+            out.push_back(static_cast<char>(value));
+        }
+        else if constexpr (std::is_enum_v<T>)
+        {
+            Serialize(static_cast<std::underlying_type_t<T>>(value), out);
+        }
+        else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+        {
+            auto number = static_cast<int64_t>(value);
+            WriteVarint(out, (static_cast<uint64_t>(number) << 1) ^ static_cast<uint64_t>(number >> 63)); // zigzag
+        }
+        else if constexpr (std::is_integral_v<T>)
+        {
+            WriteVarint(out, value);
+        }
+        else if constexpr (std::is_floating_point_v<T>)
+        {
+            out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+        }
+        else if constexpr (std::is_convertible_v<const T&, std::string_view>)
+        {
+            std::string_view string(value);
+            WriteVarint(out, string.size());
+            out.append(string);
+        }
+        else if constexpr (is_vector<T>::value)
+        {
+            WriteVarint(out, value.size());
+            for (const auto& element : value)
+                Serialize(element, out);
+        }
+        else
+        {
+            static_assert(Aggregate<T>, "reflection: type is not serializable");
+            ForEachField(value, [&](const auto& field) { Serialize(field, out); });
+        }
+    }
+
+    template<typename T>
+    std::string Serialize(const T& value)
+    {
+        std::string out;
+        Serialize(value, out);
+        return out;
+    }
+
+    template<typename T>
+    std::from_chars_result Deserialize(const char* first, const char* last, T& value)
+    {
+        if constexpr (std::is_same_v<T, bool>)
+        {
+            if (first == last)
+                return {first, std::errc::invalid_argument};
+            value = *first != 0;
+            return {first + 1, std::errc()};
+        }
+        else if constexpr (std::is_enum_v<T>)
+        {
+            std::underlying_type_t<T> number;
+            auto result = Deserialize(first, last, number);
+            if (result.ec == std::errc())
+                value = static_cast<T>(number);
+            return result;
+        }
+        else if constexpr (std::is_integral_v<T>)
+        {
+            uint64_t number;
+            auto result = ReadVarint(first, last, number);
+            if (result.ec != std::errc())
+                return result;
+            if constexpr (std::is_signed_v<T>)
+            {
+                const int64_t signed_number = static_cast<int64_t>(number >> 1) ^ -static_cast<int64_t>(number & 1);
+                if (signed_number < std::numeric_limits<T>::min() || signed_number > std::numeric_limits<T>::max())
+                    return {first, std::errc::result_out_of_range};
+                value = static_cast<T>(signed_number);
+            }
+            else
+            {
+                if (number > std::numeric_limits<T>::max())
+                    return {first, std::errc::result_out_of_range};
+                value = static_cast<T>(number);
+            }
+            return result;
+        }
+        else if constexpr (std::is_floating_point_v<T>)
+        {
+            if (static_cast<size_t>(last - first) < sizeof(T))
+                return {first, std::errc::invalid_argument};
+            std::memcpy(&value, first, sizeof(T));
+            return {first + sizeof(T), std::errc()};
+        }
+        else if constexpr (std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>)
+        {
+            uint64_t size;
+            auto result = ReadVarint(first, last, size);
+            if (result.ec != std::errc())
+                return result;
+            if (size > static_cast<uint64_t>(last - result.ptr))
+                return {result.ptr, std::errc::invalid_argument};
+            value = T(result.ptr, size); // std::string_view - без копирования, ссылается на входной буфер
+            return {result.ptr + size, std::errc()};
+        }
+        else if constexpr (is_vector<T>::value)
+        {
+            uint64_t size;
+            auto result = ReadVarint(first, last, size);
+            if (result.ec != std::errc())
+                return result;
+            if (size > static_cast<uint64_t>(last - result.ptr)) // каждый элемент занимает хотя бы 1 байт
+                return {result.ptr, std::errc::invalid_argument};
+            value.resize(size);
+            for (auto& element : value)
+            {
+                if (result = Deserialize(result.ptr, last, element); result.ec != std::errc())
+                    return result;
+            }
+            return result;
+        }
+        else
+        {
+            static_assert(Aggregate<T>, "reflection: type is not deserializable");
+            std::from_chars_result result {first, std::errc()};
+            ForEachField(value, [&](auto& field)
+            {
+                if (result.ec == std::errc())
+                    result = Deserialize(result.ptr, last, field);
+            });
+            return result;
+        }
+    }
+
+    template<typename T>
+    std::from_chars_result Deserialize(std::string_view in, T& value)
+    {
+        return Deserialize(in.data(), in.data() + in.size(), value);
+    }
+}
+
+#endif /* Reflection_h */
@@ -0,0 +1,475 @@
+#ifndef RingBuffer_h
+#define RingBuffer_h
+
+#include "Metrics.h"
+
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+/*
+ Очереди между потоками без блокировок, ограниченного размера (емкость округляется до степени 2, индекс = номер & (capacity - 1)):
+ - SpscRing - один производитель, один потребитель. Производитель пишет только _head, потребитель только _tail (каждый в своей кэш-линии),
+   чужой индекс читается редко: копия (_cached_tail / _cached_head) обновляется, только когда по ней очередь выглядит полной/пустой.
+ - MpmcQueue - много производителей и потребителей (Д. Вьюков): у каждой ячейки номер-последовательность, показывающий,
+   чья сейчас очередь - записать (sequence == pos) или прочитать (sequence == pos + 1). Позиции занимаются через compare_exchange.
+ Элементы создаются в ячейке на месте (move/emplace) и уничтожаются при извлечении - подходят move-only типы (std::unique_ptr).
+ try_* не ждут. push/pop ждут: Blocking = true - немного крутятся, потом спят на std::atomic::wait (futex в Linux, WaitOnAddress в Windows),
+ Blocking = false - крутятся с std::this_thread::yield. Пробуждение стоит производителю/потребителю лишний барьер только при Blocking = true.
+ */
+
+namespace concurrent
+{
+    inline void Pause() noexcept
+    {
+#if defined(__SSE2__) || defined(_M_X64)
+        _mm_pause();
+#else
+        std::this_thread::yield();
+#endif
+    }
+
+    /// Ожидание условия: сначала активное, затем сон на futex. Notify - только если кто-то записался в _waiters
+    class Waiter
+    {
+    public:
+        template<typename TReady>
+        void Wait(TReady&& ready) noexcept
+        {
+            static const unsigned spins = std::thread::hardware_concurrency() > 1 ? 128 : 0; // на одном ядре крутиться бессмысленно
+            for (unsigned spin = 0; spin < spins; ++spin)
+            {
+                if (ready())
+                    return;
+                Pause();
+            }
+            while (!ready())
+            {
+                uint32_t epoch = _epoch.load(std::memory_order_acquire);
+                _waiters.fetch_add(1, std::memory_order_seq_cst);
+                std::atomic_thread_fence(std::memory_order_seq_cst); // запись _waiters видна до проверки ready (пара к барьеру в Notify)
+                if (!ready())
+                    _epoch.wait(epoch, std::memory_order_acquire);
+            }
+        }
+
+        /// Будит всех спящих и обнуляет счетчик: пока разбуженный поток не запланирован, следующие Notify не делают системный вызов
+        void Notify() noexcept
+        {
+            std::atomic_thread_fence(std::memory_order_seq_cst); // изменение очереди видно до проверки _waiters
+            if (_waiters.load(std::memory_order_relaxed) && _waiters.exchange(0, std::memory_order_relaxed))
+            {
+                _epoch.fetch_add(1, std::memory_order_release);
+                _epoch.notify_all();
+            }
+        }
+
+    private:
+        std::atomic<uint32_t> _epoch {0};
+        std::atomic<uint32_t> _waiters {0};
+    };
+
+    /// Место под элемент без его создания
+    template<typename T>
+    struct Storage
+    {
+        alignas(T) std::byte data[sizeof(T)];
+
+        T* get() noexcept { return std::launder(reinterpret_cast<T*>(data)); }
+    };
+
+    template<typename T, bool Blocking = false>
+    class SpscRing
+    {
+    public:
+        explicit SpscRing(size_t capacity) : _capacity(std::bit_ceil(std::max<size_t>(capacity, 2))), _slots(std::make_unique<Storage<T>[]>(_capacity)) {}
+
+        ~SpscRing()
+        {
+            for (uint64_t i = _tail.load(std::memory_order_relaxed), head = _head.load(std::memory_order_relaxed); i != head; ++i)
+                Slot(i).get()->~T();
+        }
+
+        SpscRing(const SpscRing&) = delete;
+        SpscRing& operator=(const SpscRing&) = delete;
+
+        size_t capacity() const noexcept { return _capacity; }
+
+        /// Производитель: false - очередь полна, аргументы не тронуты
+        template<typename... Args>
+        bool try_emplace(Args&&... args)
+        {
+            uint64_t head = _head.load(std::memory_order_relaxed);
+            if (head - _cached_tail >= _capacity)
+            {
+                _cached_tail = _tail.load(std::memory_order_acquire);
+                if (head - _cached_tail >= _capacity)
+                    return false;
+            }
+            new (Slot(head).data) T(std::forward<Args>(args)...);
+            _head.store(head + 1, std::memory_order_release);
+            if constexpr (Blocking)
+                _not_empty.Notify();
+            return true;
+        }
+
+        bool try_push(T&& value) { return try_emplace(std::move(value)); }
+        bool try_push(const T& value) { return try_emplace(value); }
+
+        /// Производитель: перемещает до count элементов из first, возвращает сколько поместилось
+        template<typename TIterator>
+        size_t try_push_n(TIterator first, size_t count)
+        {
+            uint64_t head = _head.load(std::memory_order_relaxed);
+            if (_capacity - (head - _cached_tail) < count)
+                _cached_tail = _tail.load(std::memory_order_acquire);
+            size_t n = std::min<size_t>(count, _capacity - (head - _cached_tail));
+            for (size_t i = 0; i < n; ++i, ++first)
+                new (Slot(head + i).data) T(std::move(*first));
+            if (n)
+            {
+                _head.store(head + n, std::memory_order_release);
+                if constexpr (Blocking)
+                    _not_empty.Notify();
+            }
+            return n;
+        }
+
+        /// Потребитель: std::nullopt - очередь пуста
+        std::optional<T> try_pop()
+        {
+            uint64_t tail = _tail.load(std::memory_order_relaxed);
+            if (tail == _cached_head)
+            {
+                _cached_head = _head.load(std::memory_order_acquire);
+                if (tail == _cached_head)
+                    return std::nullopt;
+            }
+            T* element = Slot(tail).get();
+            std::optional<T> result(std::move(*element));
+            element->~T();
+            _tail.store(tail + 1, std::memory_order_release);
+            if constexpr (Blocking)
+                _not_full.Notify();
+            return result;
+        }
+
+        /// Потребитель: перемещает до count элементов в out, возвращает сколько извлечено
+        template<typename TOutput>
+        size_t try_pop_n(TOutput out, size_t count)
+        {
+            uint64_t tail = _tail.load(std::memory_order_relaxed);
+            if (_cached_head - tail < count)
+                _cached_head = _head.load(std::memory_order_acquire);
+            size_t n = std::min<size_t>(count, _cached_head - tail);
+            for (size_t i = 0; i < n; ++i, ++out)
+            {
+                T* element = Slot(tail + i).get();
+                *out = std::move(*element);
+                element->~T();
+            }
+            if (n)
+            {
+                _tail.store(tail + n, std::memory_order_release);
+                if constexpr (Blocking)
+                    _not_full.Notify();
+            }
+            return n;
+        }
+
+        /// Ожидание места
+        void push(T value)
+        {
+            while (!try_push(std::move(value)))
+                WaitNotFull();
+        }
+
+        /// Ожидание элемента
+        T pop()
+        {
+            while (true)
+            {
+                if (auto value = try_pop())
+                    return std::move(*value);
+                WaitNotEmpty();
+            }
+        }
+
+        /// Приблизительно: индексы читаются без согласования друг с другом
+        size_t size() const noexcept
+        {
+            return static_cast<size_t>(_head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire));
+        }
+
+    private:
+        Storage<T>& Slot(uint64_t index) noexcept { return _slots[index & (_capacity - 1)]; }
+
+        void WaitNotFull()
+        {
+            auto ready = [this]() { return _head.load(std::memory_order_relaxed) - _tail.load(std::memory_order_acquire) < _capacity; };
+            if constexpr (Blocking)
+                _not_full.Wait(ready);
+            else
+                while (!ready())
+                    std::this_thread::yield();
+        }
+
+        void WaitNotEmpty()
+        {
+            auto ready = [this]() { return _head.load(std::memory_order_acquire) != _tail.load(std::memory_order_relaxed); };
+            if constexpr (Blocking)
+                _not_empty.Wait(ready);
+            else
+                while (!ready())
+                    std::this_thread::yield();
+        }
+
+        const size_t _capacity;
+        std::unique_ptr<Storage<T>[]> _slots;
+
+        alignas(metrics::cache_line_size) std::atomic<uint64_t> _head {0}; // производитель
+        uint64_t _cached_tail = 0;
+        alignas(metrics::cache_line_size) std::atomic<uint64_t> _tail {0}; // потребитель
+        uint64_t _cached_head = 0;
+
+        alignas(metrics::cache_line_size) Waiter _not_empty;
+        Waiter _not_full;
+    };
+
+    template<typename T, bool Blocking = false>
+    class MpmcQueue
+    {
+        struct alignas(metrics::cache_line_size) Cell
+        {
+            std::atomic<uint64_t> sequence;
+            Storage<T> storage;
+        };
+
+    public:
+        explicit MpmcQueue(size_t capacity) : _capacity(std::bit_ceil(std::max<size_t>(capacity, 2))), _cells(std::make_unique<Cell[]>(_capacity))
+        {
+            for (size_t i = 0; i < _capacity; ++i)
+                _cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        ~MpmcQueue()
+        {
+            while (try_pop()) {}
+        }
+
+        MpmcQueue(const MpmcQueue&) = delete;
+        MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+        size_t capacity() const noexcept { return _capacity; }
+
+        template<typename... Args>
+        bool try_emplace(Args&&... args)
+        {
+            return Emplace<Blocking>(std::forward<Args>(args)...);
+        }
+
+        bool try_push(T&& value) { return try_emplace(std::move(value)); }
+        bool try_push(const T& value) { return try_emplace(value); }
+
+        /// Позиции в MPMC занимаются по одной, пакет экономит только пробуждения ожидающих
+        template<typename TIterator>
+        size_t try_push_n(TIterator first, size_t count)
+        {
+            size_t n = 0;
+            for (; n < count && Emplace<false>(std::move(*first)); ++n, ++first) {}
+            if constexpr (Blocking)
+                if (n)
+                    _not_empty.Notify();
+            return n;
+        }
+
+        std::optional<T> try_pop()
+        {
+            return Pop<Blocking>();
+        }
+
+        template<typename TOutput>
+        size_t try_pop_n(TOutput out, size_t count)
+        {
+            size_t n = 0;
+            for (; n < count; ++n, ++out)
+            {
+                auto value = Pop<false>();
+                if (!value)
+                    break;
+                *out = std::move(*value);
+            }
+            if constexpr (Blocking)
+                if (n)
+                    _not_full.Notify();
+            return n;
+        }
+
+        void push(T value)
+        {
+            while (!try_push(std::move(value)))
+                Wait(_not_full, [this]() { return !Full(); });
+        }
+
+        T pop()
+        {
+            while (true)
+            {
+                if (auto value = try_pop())
+                    return std::move(*value);
+                Wait(_not_empty, [this]() { return !Empty(); });
+            }
+        }
+
+    private:
+        template<bool Notify, typename... Args>
+        bool Emplace(Args&&... args)
+        {
+            uint64_t position = _enqueue.load(std::memory_order_relaxed);
+            while (true)
+            {
+                Cell& cell = _cells[position & (_capacity - 1)];
+                uint64_t sequence = cell.sequence.load(std::memory_order_acquire);
+                int64_t difference = static_cast<int64_t>(sequence - position);
+                if (difference == 0) // ячейка свободна: занимаем позицию
+                {
+                    if (_enqueue.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    {
+                        new (cell.storage.data) T(std::forward<Args>(args)...);
+                        cell.sequence.store(position + 1, std::memory_order_release);
+                        if constexpr (Notify)
+                            _not_empty.Notify();
+                        return true;
+                    }
+                }
+                else if (difference < 0) // ячейку еще не прочитали с прошлого круга: очередь полна
+                {
+                    return false;
+                }
+                else // позицию заняли другие производители
+                {
+                    position = _enqueue.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        template<bool Notify>
+        std::optional<T> Pop()
+        {
+            uint64_t position = _dequeue.load(std::memory_order_relaxed);
+            while (true)
+            {
+                Cell& cell = _cells[position & (_capacity - 1)];
+                uint64_t sequence = cell.sequence.load(std::memory_order_acquire);
+                int64_t difference = static_cast<int64_t>(sequence - (position + 1));
+                if (difference == 0) // элемент записан: занимаем позицию
+                {
+                    if (_dequeue.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    {
+                        T* element = cell.storage.get();
+                        std::optional<T> result(std::move(*element));
+                        element->~T();
+                        cell.sequence.store(position + _capacity, std::memory_order_release); // свободна для следующего круга
+                        if constexpr (Notify)
+                            _not_full.Notify();
+                        return result;
+                    }
+                }
+                else if (difference < 0) // очередь пуста
+                {
+                    return std::nullopt;
+                }
+                else
+                {
+                    position = _dequeue.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        /// Пустая/полная по ячейке на текущей позиции (для ожидания, не для решения о вставке)
+        bool Empty() const noexcept
+        {
+            uint64_t position = _dequeue.load(std::memory_order_acquire);
+            return static_cast<int64_t>(_cells[position & (_capacity - 1)].sequence.load(std::memory_order_acquire) - (position + 1)) < 0;
+        }
+
+        bool Full() const noexcept
+        {
+            uint64_t position = _enqueue.load(std::memory_order_acquire);
+            return static_cast<int64_t>(_cells[position & (_capacity - 1)].sequence.load(std::memory_order_acquire) - position) < 0;
+        }
+
+        template<typename TReady>
+        static void Wait(Waiter& waiter, TReady&& ready)
+        {
+            if constexpr (Blocking)
+                waiter.Wait(ready);
+            else
+                while (!ready())
+                    std::this_thread::yield();
+        }
+
+        const size_t _capacity;
+        std::unique_ptr<Cell[]> _cells;
+
+        alignas(metrics::cache_line_size) std::atomic<uint64_t> _enqueue {0};
+        alignas(metrics::cache_line_size) std::atomic<uint64_t> _dequeue {0};
+
+        alignas(metrics::cache_line_size) Waiter _not_empty;
+        Waiter _not_full;
+    };
+
+    /// Для сравнения: ограниченная очередь на мьютексе и условных переменных
+    template<typename T>
+    class MutexQueue
+    {
+    public:
+        explicit MutexQueue(size_t capacity) : _capacity(capacity) {}
+
+        void push(T value)
+        {
+            {
+                std::unique_lock lock(_mutex);
+                _not_full.wait(lock, [this]() { return _queue.size() < _capacity; });
+                _queue.push_back(std::move(value));
+            }
+            _not_empty.notify_one();
+        }
+
+        T pop()
+        {
+            std::unique_lock lock(_mutex);
+            _not_empty.wait(lock, [this]() { return !_queue.empty(); });
+            T value = std::move(_queue.front());
+            _queue.pop_front();
+            lock.unlock();
+            _not_full.notify_one();
+            return value;
+        }
+
+    private:
+        const size_t _capacity;
+        std::mutex _mutex;
+        std::condition_variable _not_empty;
+        std::condition_variable _not_full;
+        std::deque<T> _queue;
+    };
+}
+
+#endif /* RingBuffer_h */
@@ -0,0 +1,229 @@
+#ifndef SFINAE_h
+#define SFINAE_h
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define SFINAE_AVX2 1
+#define SFINAE_AVX 1
+#elif defined(__AVX__)
+#include <immintrin.h>
+#define SFINAE_AVX 1
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SFINAE_SSE2 1
+#endif
+#if defined(__SSE4_1__)
+#include <smmintrin.h>
+#define SFINAE_SSE41 1
+#endif
+
+namespace SFINAE
+{
+    template <typename T>
+    struct Number
+    {
+        Number(const T& number) : value(number) {}
+
+        T value;
+    };
+
+    /*
+      Для Number<int> не работает: при вызове. Эта функция пытается найти int.value, которого не существует. Ошибку: часть else не удалена из функции (error: request for member ‘value’ in ‘t’, which is of non-class type ‘const int’).
+    */
+    namespace IS_ARITHMETIC
+    {
+        template<typename T>
+        T Square(const T& number)
+        {
+            if (std::is_arithmetic<T>::value)
+            {
+                return number * number;
+            }
+            else
+            {
+                return number.value * number.value;
+            }
+        }
+    }
+
+    /*
+    * C++14: Чтобы решить проблему Number<int>, нужны два шаблона функций, которые проверяют передаваемый тип на арифметическу.
+    */
+    namespace ENABLE_IF
+    {
+        template<typename T>
+        typename std::enable_if<std::is_arithmetic<T>::value, T>::type Square(const T& number)
+        {
+            return number * number;
+        }
+
+        template<typename T>
+        typename std::enable_if<!std::is_arithmetic<T>::value, T>::type Square(const T& number)
+        {
+            return number.value * number.value;
+        }
+
+        // template<typename T>
+        // typename std::enable_if<std::has_begin<T>::value, T>::type Square(const T& number)
+    }
+
+    /*
+      C++17: Здесь используется только один шаблон функции (что упрощает код вместо std::enable_if).
+      Компилятор берет только ветку с истинным условием (true) и отбрасывает другие.
+    */
+    namespace CONSTEXPR
+    {
+        template<typename T>
+        T Square(const T& number)
+        {
+            if constexpr (std::is_arithmetic<T>::value) // Проверка нужна для класса Number, иначе ошибка: не найден operator*
+            {
+                return number * number;
+            }
+            else
+            {
+                return number.value * number.value;
+            }
+        }
+    }
+    /*
+      C++20: Концепты компилируются быстрее обычного SFINAE (std::enable_if и constexpr) и условия в них можно расширять. Версия C++20 вернулась обратно к двум функциям, но теперь код намного читабельнее, чем с std::enable_if.
+    */
+    namespace CONCEPT
+    {
+        template<typename T>
+        concept Arithmetic = std::is_arithmetic<T>::value;
+
+        template <typename T>
+        concept has_member_value = requires (const T& t)
+        {
+            std::is_arithmetic<decltype(T::value)>::value;
+        };
+
+        template<Arithmetic T>
+        T Square(const T& number)
+        {
+            return number * number;
+        }
+
+        template<has_member_value T>
+        T Square(const T& number)
+        {
+            return number.value * number.value;
+        }
+
+        /*
+          Обертка над одним числом (как Number<T>), которую можно читать как массив самих чисел: standard-layout, value - первый и единственный член
+          (размер и выравнивание совпадают с типом value), поэтому адрес объекта совпадает с адресом value.
+        */
+        template<typename T>
+        concept scalar_wrapper = has_member_value<T> && std::is_standard_layout_v<T> && Arithmetic<decltype(T::value)>
+                                 && sizeof(T) == sizeof(decltype(T::value)) && alignof(T) == alignof(decltype(T::value));
+
+        /*
+          SIMD-ядро для массива чисел: набор инструкций выбирается при компиляции (-mavx2/-mavx/-msse4.1, в x86-64 SSE2 есть всегда),
+          для остальных типов и платформ - обычный цикл, который компилятор может векторизовать сам. numbers и result могут совпадать.
+        */
+        template<Arithmetic T>
+        void SquareKernel(const T* numbers, T* result, size_t size) noexcept
+        {
+            size_t i = 0;
+            if constexpr (std::is_same_v<T, float>)
+            {
+#if defined(SFINAE_AVX)
+                for (; i + 8 <= size; i += 8)
+                {
+                    __m256 block = _mm256_loadu_ps(numbers + i);
+                    _mm256_storeu_ps(result + i, _mm256_mul_ps(block, block));
+                }
+#elif defined(SFINAE_SSE2)
+                for (; i + 4 <= size; i += 4)
+                {
+                    __m128 block = _mm_loadu_ps(numbers + i);
+                    _mm_storeu_ps(result + i, _mm_mul_ps(block, block));
+                }
+#endif
+            }
+            else if constexpr (std::is_same_v<T, double>)
+            {
+#if defined(SFINAE_AVX)
+                for (; i + 4 <= size; i += 4)
+                {
+                    __m256d block = _mm256_loadu_pd(numbers + i);
+                    _mm256_storeu_pd(result + i, _mm256_mul_pd(block, block));
+                }
+#elif defined(SFINAE_SSE2)
+                for (; i + 2 <= size; i += 2)
+                {
+                    __m128d block = _mm_loadu_pd(numbers + i);
+                    _mm_storeu_pd(result + i, _mm_mul_pd(block, block));
+                }
+#endif
+            }
+            else if constexpr (std::is_integral_v<T> && sizeof(T) == 4)
+            {
+#if defined(SFINAE_AVX2)
+                for (; i + 8 <= size; i += 8)
+                {
+                    __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(numbers + i));
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(result + i), _mm256_mullo_epi32(block, block));
+                }
+#elif defined(SFINAE_SSE41)
+                for (; i + 4 <= size; i += 4)
+                {
+                    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(numbers + i));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(result + i), _mm_mullo_epi32(block, block));
+                }
+#endif
+            }
+
+            for (; i < size; ++i) // хвост и типы без SIMD-ядра
+                result[i] = static_cast<T>(numbers[i] * numbers[i]);
+        }
+
+        /// Пакетный Square: result[i] = Square(numbers[i]), result.size() >= numbers.size()
+        template<Arithmetic T>
+        void Square(std::span<const T> numbers, std::span<T> result) noexcept
+        {
+            assert(result.size() >= numbers.size());
+            SquareKernel(numbers.data(), result.data(), numbers.size());
+        }
+
+        /// Пакетный Square для Number<T>: если обертку можно читать как массив чисел - то же SIMD-ядро, иначе поэлементно
+        template<has_member_value T>
+        void Square(std::span<const T> numbers, std::span<T> result) noexcept
+        {
+            assert(result.size() >= numbers.size());
+            if constexpr (scalar_wrapper<T>)
+            {
+                using Value = decltype(T::value);
+                SquareKernel(reinterpret_cast<const Value*>(numbers.data()), reinterpret_cast<Value*>(result.data()), numbers.size());
+            }
+            else
+            {
+                for (size_t i = 0; i < numbers.size(); ++i)
+                    result[i] = Square(numbers[i]);
+            }
+        }
+
+        /// Пакетный Square с новым массивом (копия, затем возведение в квадрат на месте: Number<T> нельзя создать без значения)
+        template<typename T>
+        requires Arithmetic<T> || has_member_value<T>
+        std::vector<T> Square(std::span<const T> numbers)
+        {
+            std::vector<T> result(numbers.begin(), numbers.end());
+            Square(std::span<const T>(result), std::span<T>(result));
+            return result;
+        }
+    }
+}
+
+#endif /* SFINAE_h */
@@ -0,0 +1,153 @@
+#ifndef SharedString_h
+#define SharedString_h
+
+#include <algorithm>
+#include <atomic>
+#include <compare>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+/*
+ shared_string - неизменяемая строка в одном блоке кучи вместе со счетчиком ссылок (как std::shared_ptr, но без отдельного управляющего блока).
+ shared_slice - срез такой строки: указатель на блок + (data, size). Срез продлевает жизнь всего буфера, поэтому, в отличие от
+ std::string_view, не становится висячим, когда исходная shared_string уничтожена. Создание/копирование среза - атомарное увеличение счетчика,
+ без выделения памяти и копирования символов (std::string - выделение на каждое слово длиннее 15 символов).
+ Содержимое не меняется, счетчик атомарный - срезы можно передавать между потоками. Преобразование в std::string_view - бесплатно
+ (но string_view, как всегда, живет не дольше среза).
+ Размер среза - 3 указателя (std::string_view - 2, std::string - 4).
+ */
+
+namespace containers
+{
+    class shared_slice
+    {
+    public:
+        static constexpr size_t npos = std::string_view::npos;
+
+        shared_slice() noexcept = default;
+
+        shared_slice(const shared_slice& other) noexcept : _buffer(other._buffer), _data(other._data), _size(other._size)
+        {
+            Retain();
+        }
+
+        shared_slice(shared_slice&& other) noexcept
+            : _buffer(std::exchange(other._buffer, nullptr)), _data(std::exchange(other._data, empty_data)), _size(std::exchange(other._size, 0)) {}
+
+        shared_slice& operator=(shared_slice other) noexcept
+        {
+            swap(other);
+            return *this;
+        }
+
+        ~shared_slice() { Release(); }
+
+        void swap(shared_slice& other) noexcept
+        {
+            std::swap(_buffer, other._buffer);
+            std::swap(_data, other._data);
+            std::swap(_size, other._size);
+        }
+
+        const char* data() const noexcept { return _data; }
+        size_t size() const noexcept { return _size; }
+        bool empty() const noexcept { return _size == 0; }
+        const char* begin() const noexcept { return _data; }
+        const char* end() const noexcept { return _data + _size; }
+        char operator[](size_t index) const noexcept { return _data[index]; }
+
+        std::string_view view() const noexcept { return {_data, _size}; }
+        operator std::string_view() const noexcept { return view(); }
+
+        /// Срез того же буфера: без выделения памяти
+        shared_slice substr(size_t position, size_t count = npos) const
+        {
+            if (position > _size)
+                throw std::out_of_range("shared_slice::substr");
+            return shared_slice(_buffer, _data + position, std::min(count, _size - position));
+        }
+
+        /// Число срезов (и shared_string), владеющих буфером; 0 - пустой срез без буфера
+        size_t use_count() const noexcept { return _buffer ? _buffer->references.load(std::memory_order_relaxed) : 0; }
+
+        friend bool operator==(const shared_slice& left, std::string_view right) noexcept { return left.view() == right; }
+        friend auto operator<=>(const shared_slice& left, std::string_view right) noexcept { return left.view() <=> right; }
+        friend bool operator==(const shared_slice& left, const shared_slice& right) noexcept { return left.view() == right.view(); }
+        friend auto operator<=>(const shared_slice& left, const shared_slice& right) noexcept { return left.view() <=> right.view(); }
+
+        friend std::ostream& operator<<(std::ostream& out, const shared_slice& slice) { return out << slice.view(); }
+
+    protected:
+        struct Buffer
+        {
+            std::atomic<size_t> references {1};
+            // далее - символы и '\0'
+
+            char* chars() noexcept { return reinterpret_cast<char*>(this + 1); }
+        };
+
+        static constexpr const char* empty_data = "";
+
+        shared_slice(Buffer* buffer, const char* data, size_t size) noexcept : _buffer(buffer), _data(data), _size(size)
+        {
+            Retain();
+        }
+
+        /// Новый буфер со счетчиком 1 (владение передается срезу без Retain)
+        static shared_slice Allocate(std::string_view text)
+        {
+            if (text.empty())
+                return {};
+            auto* buffer = new (::operator new(sizeof(Buffer) + text.size() + 1)) Buffer;
+            std::memcpy(buffer->chars(), text.data(), text.size());
+            buffer->chars()[text.size()] = '\0';
+
+            shared_slice result;
+            result._buffer = buffer;
+            result._data = buffer->chars();
+            result._size = text.size();
+            return result;
+        }
+
+    private:
+        void Retain() const noexcept
+        {
+            if (_buffer)
+                _buffer->references.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void Release() noexcept
+        {
+            // acq_rel: все чтения буфера другими владельцами завершены до освобождения
+            if (_buffer && _buffer->references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                _buffer->~Buffer();
+                ::operator delete(_buffer);
+            }
+        }
+
+        Buffer* _buffer = nullptr;
+        const char* _data = empty_data;
+        size_t _size = 0;
+    };
+
+    /// Владелец буфера целиком: символы копируются один раз при создании, дальше - только срезы
+    class shared_string : public shared_slice
+    {
+    public:
+        shared_string() noexcept = default;
+        explicit shared_string(std::string_view text) : shared_slice(Allocate(text)) {}
+        explicit shared_string(const char* text) : shared_string(std::string_view(text)) {}
+
+        /// Весь буфер заканчивается нулевым символом (в отличие от среза)
+        const char* c_str() const noexcept { return data(); }
+    };
+}
+
+#endif /* SharedString_h */
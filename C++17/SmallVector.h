@@ -0,0 +1,442 @@
+#ifndef SmallVector_h
+#define SmallVector_h
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+/*
+ small_vector<T, N> - вектор, первые N элементов которого хранятся внутри объекта (на стеке), а не в куче.
+ Память в куче выделяется, только когда элементов становится больше N, - для коротких последовательностей (2-3 слова в строке протокола) выделений нет.
+ Интерфейс повторяет std::vector: итераторы-указатели, emplace/insert/erase, reserve, resize, swap, сравнения.
+ Отличие от std::vector: перемещение small_vector, элементы которого лежат внутри объекта, перемещает каждый элемент (O(n)), а не указатель,
+ поэтому итераторы и ссылки после перемещения/swap указывают на старый объект.
+ */
+
+namespace containers
+{
+    template<typename T, size_t N, typename Allocator = std::allocator<T>>
+    class small_vector
+    {
+        using AllocatorTraits = std::allocator_traits<Allocator>;
+
+    public:
+        using value_type = T;
+        using allocator_type = Allocator;
+        using size_type = size_t;
+        using difference_type = std::ptrdiff_t;
+        using reference = T&;
+        using const_reference = const T&;
+        using pointer = T*;
+        using const_pointer = const T*;
+        using iterator = T*;
+        using const_iterator = const T*;
+        using reverse_iterator = std::reverse_iterator<iterator>;
+        using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+        static constexpr size_t inline_capacity = N;
+
+        small_vector() noexcept(noexcept(Allocator())) = default;
+        explicit small_vector(const Allocator& allocator) noexcept : _allocator(allocator) {}
+
+        explicit small_vector(size_t count, const Allocator& allocator = Allocator()) : _allocator(allocator)
+        {
+            resize(count);
+        }
+
+        small_vector(size_t count, const T& value, const Allocator& allocator = Allocator()) : _allocator(allocator)
+        {
+            assign(count, value);
+        }
+
+        template<std::input_iterator TIterator>
+        small_vector(TIterator first, TIterator last, const Allocator& allocator = Allocator()) : _allocator(allocator)
+        {
+            assign(first, last);
+        }
+
+        small_vector(std::initializer_list<T> list, const Allocator& allocator = Allocator()) : _allocator(allocator)
+        {
+            assign(list.begin(), list.end());
+        }
+
+        small_vector(const small_vector& other) : _allocator(AllocatorTraits::select_on_container_copy_construction(other._allocator))
+        {
+            assign(other.begin(), other.end());
+        }
+
+        small_vector(small_vector&& other) noexcept(std::is_nothrow_move_constructible_v<T>) : _allocator(std::move(other._allocator))
+        {
+            Steal(std::move(other));
+        }
+
+        ~small_vector()
+        {
+            clear();
+            Deallocate();
+        }
+
+        small_vector& operator=(const small_vector& other)
+        {
+            if (this != &other)
+                assign(other.begin(), other.end());
+            return *this;
+        }
+
+        /// Буфер кучи other забирается, только если его потом можно освободить своим аллокатором:
+        /// аллокатор переходит вместе с буфером (propagate_on_container_move_assignment) или аллокаторы равны, иначе элементы перемещаются по одному
+        small_vector& operator=(small_vector&& other) noexcept(std::is_nothrow_move_constructible_v<T> &&
+                                                               (AllocatorTraits::propagate_on_container_move_assignment::value || AllocatorTraits::is_always_equal::value))
+        {
+            if (this != &other)
+            {
+                clear();
+                if constexpr (AllocatorTraits::propagate_on_container_move_assignment::value)
+                {
+                    Deallocate();
+                    _allocator = std::move(other._allocator);
+                    Steal(std::move(other));
+                }
+                else
+                {
+                    if (AllocatorTraits::is_always_equal::value || _allocator == other._allocator)
+                    {
+                        Deallocate();
+                        Steal(std::move(other));
+                    }
+                    else
+                    {
+                        reserve(other.size());
+                        std::uninitialized_move(other.begin(), other.end(), _data);
+                        _size = other.size();
+                        other.clear();
+                    }
+                }
+            }
+            return *this;
+        }
+
+        small_vector& operator=(std::initializer_list<T> list)
+        {
+            assign(list.begin(), list.end());
+            return *this;
+        }
+
+        void assign(size_t count, const T& value)
+        {
+            clear();
+            reserve(count);
+            std::uninitialized_fill_n(_data, count, value);
+            _size = count;
+        }
+
+        template<std::input_iterator TIterator>
+        void assign(TIterator first, TIterator last)
+        {
+            clear();
+            if constexpr (std::forward_iterator<TIterator>)
+                reserve(static_cast<size_t>(std::distance(first, last)));
+            for (; first != last; ++first)
+                emplace_back(*first);
+        }
+
+        void assign(std::initializer_list<T> list)
+        {
+            assign(list.begin(), list.end());
+        }
+
+        allocator_type get_allocator() const noexcept { return _allocator; }
+
+        /// Доступ к элементам
+        reference at(size_t index)
+        {
+            if (index >= _size)
+                throw std::out_of_range("small_vector::at");
+            return _data[index];
+        }
+
+        const_reference at(size_t index) const
+        {
+            return const_cast<small_vector*>(this)->at(index);
+        }
+
+        reference operator[](size_t index) noexcept { return _data[index]; }
+        const_reference operator[](size_t index) const noexcept { return _data[index]; }
+        reference front() noexcept { return _data[0]; }
+        const_reference front() const noexcept { return _data[0]; }
+        reference back() noexcept { return _data[_size - 1]; }
+        const_reference back() const noexcept { return _data[_size - 1]; }
+        T* data() noexcept { return _data; }
+        const T* data() const noexcept { return _data; }
+
+        /// Итераторы
+        iterator begin() noexcept { return _data; }
+        iterator end() noexcept { return _data + _size; }
+        const_iterator begin() const noexcept { return _data; }
+        const_iterator end() const noexcept { return _data + _size; }
+        const_iterator cbegin() const noexcept { return _data; }
+        const_iterator cend() const noexcept { return _data + _size; }
+        reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+        reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+        const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator(end()); }
+        const_reverse_iterator rend() const noexcept { return const_reverse_iterator(begin()); }
+        const_reverse_iterator crbegin() const noexcept { return rbegin(); }
+        const_reverse_iterator crend() const noexcept { return rend(); }
+
+        /// Размер
+        bool empty() const noexcept { return _size == 0; }
+        size_t size() const noexcept { return _size; }
+        size_t max_size() const noexcept { return AllocatorTraits::max_size(_allocator); }
+        size_t capacity() const noexcept { return _capacity; }
+        /// true - элементы лежат внутри объекта, выделения памяти в куче не было
+        bool is_inline() const noexcept { return _data == Inline(); }
+
+        void reserve(size_t capacity)
+        {
+            if (capacity > _capacity)
+                Reallocate(capacity);
+        }
+
+        /// Возвращает элементы во внутренний буфер, если они в нем помещаются
+        void shrink_to_fit()
+        {
+            if (is_inline() || _size == _capacity)
+                return;
+            if (_size <= N)
+            {
+                T* heap = _data;
+                size_t capacity = _capacity;
+                std::uninitialized_move(heap, heap + _size, Inline());
+                std::destroy(heap, heap + _size);
+                AllocatorTraits::deallocate(_allocator, heap, capacity);
+                _data = Inline();
+                _capacity = N;
+            }
+            else
+            {
+                Reallocate(_size);
+            }
+        }
+
+        /// Изменение
+        void clear() noexcept
+        {
+            std::destroy(_data, _data + _size);
+            _size = 0;
+        }
+
+        template<typename... Args>
+        reference emplace_back(Args&&... args)
+        {
+            if (_size == _capacity)
+                return GrowAndEmplace(std::forward<Args>(args)...);
+
+            T* element = std::construct_at(_data + _size, std::forward<Args>(args)...);
+            ++_size;
+            return *element;
+        }
+
+        void push_back(const T& value) { emplace_back(value); }
+        void push_back(T&& value) { emplace_back(std::move(value)); }
+
+        void pop_back() noexcept
+        {
+            std::destroy_at(_data + --_size);
+        }
+
+        /// Вставка в середину: элемент добавляется в конец и поворотом (std::rotate) переносится на место
+        template<typename... Args>
+        iterator emplace(const_iterator position, Args&&... args)
+        {
+            size_t index = position - _data;
+            emplace_back(std::forward<Args>(args)...);
+            std::rotate(_data + index, _data + _size - 1, _data + _size);
+            return _data + index;
+        }
+
+        iterator insert(const_iterator position, const T& value) { return emplace(position, value); }
+        iterator insert(const_iterator position, T&& value) { return emplace(position, std::move(value)); }
+
+        iterator insert(const_iterator position, size_t count, const T& value)
+        {
+            size_t index = position - _data;
+            T copy(value); // value может ссылаться на элемент этого же вектора
+            reserve(_size + count);
+            std::uninitialized_fill_n(_data + _size, count, copy);
+            _size += count;
+            std::rotate(_data + index, _data + _size - count, _data + _size);
+            return _data + index;
+        }
+
+        template<std::input_iterator TIterator>
+        iterator insert(const_iterator position, TIterator first, TIterator last)
+        {
+            size_t index = position - _data;
+            size_t old_size = _size;
+            if constexpr (std::forward_iterator<TIterator>)
+                reserve(_size + static_cast<size_t>(std::distance(first, last)));
+            for (; first != last; ++first)
+                emplace_back(*first);
+            std::rotate(_data + index, _data + old_size, _data + _size);
+            return _data + index;
+        }
+
+        iterator insert(const_iterator position, std::initializer_list<T> list)
+        {
+            return insert(position, list.begin(), list.end());
+        }
+
+        iterator erase(const_iterator position)
+        {
+            return erase(position, position + 1);
+        }
+
+        iterator erase(const_iterator first, const_iterator last)
+        {
+            T* begin = _data + (first - _data);
+            T* end = _data + (last - _data);
+            if (begin != end)
+            {
+                T* new_end = std::move(end, _data + _size, begin);
+                std::destroy(new_end, _data + _size);
+                _size = new_end - _data;
+            }
+            return begin;
+        }
+
+        void resize(size_t count)
+        {
+            Resize(count);
+        }
+
+        void resize(size_t count, const T& value)
+        {
+            Resize(count, value);
+        }
+
+        void swap(small_vector& other) noexcept(std::is_nothrow_move_constructible_v<T> && std::is_nothrow_move_assignable_v<small_vector>)
+        {
+            small_vector temp(std::move(other));
+            other = std::move(*this);
+            *this = std::move(temp);
+        }
+
+        friend void swap(small_vector& lhs, small_vector& rhs) noexcept(noexcept(lhs.swap(rhs)))
+        {
+            lhs.swap(rhs);
+        }
+
+        friend bool operator==(const small_vector& lhs, const small_vector& rhs)
+        {
+            return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+        }
+
+        friend auto operator<=>(const small_vector& lhs, const small_vector& rhs)
+        {
+            return std::lexicographical_compare_three_way(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+        }
+
+    private:
+        T* Inline() noexcept { return reinterpret_cast<T*>(_inline); }
+        const T* Inline() const noexcept { return reinterpret_cast<const T*>(_inline); }
+
+        /// Перемещение из other: буфер кучи забирается целиком, внутренние элементы перемещаются по одному
+        void Steal(small_vector&& other)
+        {
+            if (other.is_inline())
+            {
+                _data = Inline();
+                _capacity = N;
+                std::uninitialized_move(other._data, other._data + other._size, _data);
+                _size = other._size;
+                other.clear();
+            }
+            else
+            {
+                _data = std::exchange(other._data, other.Inline());
+                _size = std::exchange(other._size, 0);
+                _capacity = std::exchange(other._capacity, N);
+            }
+        }
+
+        void Deallocate() noexcept
+        {
+            if (!is_inline())
+                AllocatorTraits::deallocate(_allocator, _data, _capacity);
+            _data = Inline();
+            _capacity = N;
+        }
+
+        void Reallocate(size_t capacity)
+        {
+            T* data = AllocatorTraits::allocate(_allocator, capacity);
+            MoveTo(data);
+            Replace(data, capacity);
+        }
+
+        /// Новый элемент создается до переноса старых: аргументы могут ссылаться на элементы этого же вектора
+        template<typename... Args>
+        reference GrowAndEmplace(Args&&... args)
+        {
+            size_t capacity = std::max<size_t>(2 * _capacity, 1);
+            T* data = AllocatorTraits::allocate(_allocator, capacity);
+            try
+            {
+                std::construct_at(data + _size, std::forward<Args>(args)...);
+            }
+            catch (...)
+            {
+                AllocatorTraits::deallocate(_allocator, data, capacity);
+                throw;
+            }
+            MoveTo(data);
+            Replace(data, capacity);
+            ++_size;
+            return _data[_size - 1];
+        }
+
+        void MoveTo(T* data)
+        {
+            if constexpr (std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>)
+                std::uninitialized_move(_data, _data + _size, data);
+            else
+                std::uninitialized_copy(_data, _data + _size, data);
+        }
+
+        void Replace(T* data, size_t capacity) noexcept
+        {
+            std::destroy(_data, _data + _size);
+            if (!is_inline())
+                AllocatorTraits::deallocate(_allocator, _data, _capacity);
+            _data = data;
+            _capacity = capacity;
+        }
+
+        template<typename... Args>
+        void Resize(size_t count, const Args&... value)
+        {
+            if (count < _size)
+            {
+                std::destroy(_data + count, _data + _size);
+                _size = count;
+                return;
+            }
+            reserve(count);
+            for (; _size < count; ++_size)
+                std::construct_at(_data + _size, value...);
+        }
+
+        T* _data = Inline();
+        size_t _size = 0;
+        size_t _capacity = N;
+        alignas(T) std::byte _inline[(N ? N : 1) * sizeof(T)];
+        [[no_unique_address]] Allocator _allocator;
+    };
+}
+
+#endif /* SmallVector_h */
@@ -0,0 +1,125 @@
+#ifndef StringView_h
+#define StringView_h
+
+#include "SharedString.h"
+#include "SmallVector.h"
+#include "Trace.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace STRING_VIEW
+{
+    /*
+     Разделяет строку на слова через 2 указателя: слово - срез text.substr(first, count) типа, который возвращает substr у TText
+     (std::string - копия, std::string_view - без копирования, containers::shared_slice - срез общего буфера), в любой контейнер с emplace_back.
+     Разделитель - любой из символов delims, последнее слово без разделителя в конце тоже попадает в результат.
+     Используется split_by_space_shared_slice и pipeline; split_by_space_string/split_by_space_string_view сохраняют исходное поведение (split_by_delimiter).
+     Time: O(n)
+     */
+    template<typename TText, typename TContainer>
+    void split_words(const TText& text, TContainer& result, std::string_view delims = " ")
+    {
+        const std::string_view view = text;
+        size_t first = 0;
+
+        while (first < view.size()) // проверяем указатель на выход за переделы
+        {
+            // один разделитель - memchr, несколько - поиск любого из них
+            size_t second = delims.size() == 1 ? view.find(delims.front(), first) : view.find_first_of(delims, first);
+            if (second == std::string_view::npos)
+                second = view.size(); // последнее слово
+
+            if (first != second) // пробел найден
+                result.emplace_back(text.substr(first, second - first));
+
+            first = second + 1; // пропускаем пробел
+        }
+    }
+    /*
+     Исходный цикл split_by_space_string/split_by_space_string_view: delims - подстрока-разделитель (text.find(delims)), после нее пропускается
+     один символ, слово после последнего разделителя в результат не попадает ("a b" -> {"a"}).
+     Time: O(n)
+     */
+    template<typename TText, typename TContainer>
+    void split_by_delimiter(const TText& text, TContainer& result, std::string_view delims)
+    {
+        const std::string_view view = text;
+        size_t first = 0;
+
+        while (first < view.size()) // проверяем указатель на выход за переделы
+        {
+            size_t second = view.find(delims, first); // поиск с определенного индекса
+            if (second == std::string_view::npos)
+                break;
+
+            if (first != second) // пробел найден
+                result.emplace_back(text.substr(first, second - first));
+
+            first = second + 1; // пропускаем пробел
+        }
+    }
+    /*
+     Разделяет строку на слова через 2 указателя
+     Time: O(n)
+     Memory: O(n)
+     */
+    inline std::vector<std::string> split_by_space_string(const std::string& text, std::string delims = " ")
+    {
+        TRACE_SCOPE("split_by_space_string");
+        std::vector<std::string> result;
+        split_by_delimiter(text, result, delims);
+        return result;
+    }
+    /*
+     Разделяет строку на слова через 2 указателя
+     Time: O(n)
+     Memory: O(1) - string_view, но если строка изменится или выйдет за пределы видимости стека, то undefined behavior (UB).
+     */
+    inline std::vector<std::string_view> split_by_space_string_view(const std::string_view& text, const std::string_view& delims = " ")
+    {
+        TRACE_SCOPE("split_by_space_string_view");
+        std::vector<std::string_view> result;
+        split_by_delimiter(text, result, delims);
+        return result;
+    }
+    /*
+     Разделяет строку на слова через 2 указателя в срезы общего буфера: разделитель - любой из символов delims, последнее слово попадает в результат
+     Time: O(n)
+     Memory: O(1) на слово - символы не копируются, каждый срез увеличивает счетчик ссылок буфера, поэтому слова остаются валидными
+     и после уничтожения исходной shared_string (в отличие от string_view), и в других потоках.
+     */
+    inline std::vector<containers::shared_slice> split_by_space_shared_slice(const containers::shared_slice& text, const std::string_view& delims = " ")
+    {
+        TRACE_SCOPE("split_by_space_shared_slice");
+        std::vector<containers::shared_slice> result;
+        split_words(text, result, delims);
+        return result;
+    }
+    /*
+     Разделяет строку на слова через 2 указателя в переданный контейнер с emplace_back, например, small_vector: для 2-3 слов память в куче не выделяется
+     Time: O(n)
+     Memory: O(1) - string_view, но если строка изменится или выйдет за пределы видимости стека, то undefined behavior (UB).
+     */
+    template<typename TContainer>
+    requires requires (TContainer& container, std::string_view word) { container.emplace_back(word); }
+    void split_by_space_string_view(const std::string_view& text, TContainer& result, const std::string_view& delims = " ")
+    {
+        TRACE_SCOPE("split_by_space_string_view");
+        split_by_delimiter(text, result, delims);
+    }
+    /*
+     Разделяет строку на слова через 2 указателя в small_vector<std::string, N>: строки копируются, но сам массив до N слов не выделяется в куче
+     Time: O(n)
+     Memory: O(n)
+     */
+    template<size_t N>
+    void split_by_space_string(const std::string& text, containers::small_vector<std::string, N>& result, std::string delims = " ")
+    {
+        TRACE_SCOPE("split_by_space_string");
+        split_by_delimiter(text, result, delims);
+    }
+}
+
+#endif /* StringView_h */
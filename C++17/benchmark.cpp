@@ -0,0 +1,1403 @@
+#include "AllocationProfiler.h"
+#include "Benchmark.h"
+#include "Encoding.h"
+#include "FlatMap.h"
+#include "Format.h"
+#include "GroupBy.h"
+#include "LookupCache.h"
+#include "MembershipFilter.h"
+#include "Metrics.h"
+#include "MultiSearch.h"
+#include "PersonFile.h"
+#include "Pipeline.h"
+#include "RadixSort.h"
+#include "Reflection.h"
+#include "RingBuffer.h"
+#include "SFINAE.h"
+#include "StringView.h"
+#include "Trace.h"
+
+#include <any>
+#include <array>
+#include <barrier>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <span>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+#if __has_include(<format>)
+#include <format>
+#endif
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// std::execution::par в libstdc++ требует TBB: CMake определяет PARALLEL_STL, если TBB найден, MSVC поддерживает его сам
+#if defined(PARALLEL_STL) || defined(_MSC_VER)
+#include <execution>
+#define BENCHMARK_PARALLEL_STL 1
+#endif
+
+#ifndef BENCHMARK_ALLOCATIONS
+#define BENCHMARK_ALLOCATIONS 0
+#endif
+
+/*
+ Микробенчмарки пар "до C++17 / C++17", о скорости которых говорится в комментариях main.cpp:
+ - split_by_space_string (копии std::string) против split_by_space_string_view против split_by_space_shared_slice (срезы общего буфера),
+   плюс память, удерживаемая результатом
+ - разбиение строк протокола в std::vector<std::string_view> против containers::small_vector<std::string_view, 8> (size - число строк)
+ - std::to_string против std::to_chars
+ - std::any против std::variant
+ - SFINAE::ENABLE_IF::Square против SFINAE::CONSTEXPR::Square против SFINAE::CONCEPT::Square
+ - поэлементный CONCEPT::Square против пакетного CONCEPT::Square(std::span) для float и Number<float> (до 100M элементов, ~800 МБ)
+ - общий std::atomic против metrics::Counter/Histogram при 1-64 потоках (size - число потоков, время - на весь прогон по 10'000 записей в потоке)
+ - поиск в std::map против containers::flat_map (Sorted и Eytzinger) на 1K, 1M и 100M ключей uint32_t, ~50% промахов
+   (size - число поисков за итерацию; std::map на 100M ключей - ~5 ГБ, пропускается, если не помещается в половину памяти)
+ - lookup_cache::ShardedClockCache::get_or_compute против std::unordered_map под мьютексом: 1M поисков по Ципфу в 1..hardware_concurrency
+   потоках (size - число потоков), плюс попадания и совмещенные промахи кэша
+ - concurrent::SpscRing и concurrent::MpmcQueue против concurrent::MutexQueue: пропускная способность (size - число элементов за прогон,
+   потоки производителей/потребителей в имени) и задержка туда-обратно между двумя потоками (size - 1 круг)
+ - encoding::SCALAR (посимвольно) против блочных Cp1251ToUtf8/Utf8ToCp1251/ValidateUtf8 на русском тексте и на ASCII (size - байт входа)
+ - search::Naive (text.find по каждой подстроке) против search::Searcher (Teddy и Aho-Corasick) на журнале для 8 и 64 подстрок (size - байт журнала)
+ - сортировка записей по (age, name): std::sort/std::stable_sort (и с std::execution::par при TBB) против radix::SortIndices + Permute,
+   по name: std::stable_sort против radix::SortIndicesByString, top-k: std::partial_sort против radix::TopK (size - число записей,
+   время включает копию записей - строка "copy"; порядок каждого результата один раз сверяется с std::stable_sort)
+ - сумма/среднее/норма 1M чисел из текста: pipeline::RunMaterialized против конвейера pipeline::Run в 1..hardware_concurrency потоках
+   (size - число чисел), плюс задержка до первого результата конвейера
+ - группировка 1M строк по городу (равномерно по 1'000 ключей и по закону Зипфа): std::map<std::string, ...> против group_by::GroupBy
+   в 1 и hardware_concurrency потоках, для 2M ключей - со сбросом на диск (size - число строк, сброшенные МБ выводятся отдельно).
+   --group-by-rows 100000000 - 100M строк за итерацию: пакет 1M строк подается повторно в тот же запрос (минуты на каждый замер)
+ - поиск в реестре std::map<std::string, std::any, std::less<>> на 100'000 ключей: std::map::find против membership::Filtered с BloomFilter (1%)
+   и с CuckooFilter<uint16_t> при доле попаданий 0-90% (size - число поисков за итерацию), плюс память и доля ложных срабатываний фильтров
+ - загрузка 10M записей: person_file::Reader (mmap) против std::ifstream >> по текстовому файлу, холодный старт (файл вытеснен из кэша страниц)
+   и теплый, плюс последовательное чтение файла как нижняя граница (size - число записей; ~800 МБ во временном каталоге)
+ - сериализация 1'000 записей с вложенной структурой: вручную против reflection::Serialize, и reflection::Deserialize (size - число записей)
+ - пустой цикл против цикла с TRACE_SCOPE (стоимость трассировки, включая опустошение буфера через trace::Discard)
+ - std::ostringstream против std::snprintf против std::format_to (если есть <format>) против format::FormatTo со строкой формата времени компиляции
+ Каждая пара запускается на нескольких размерах входных данных, выводятся медиана и перцентили и аппаратные счетчики (perf_event_open).
+ Число выделений памяти на итерацию и память результата split - только при сборке с -DBENCHMARK_ALLOCATIONS=ON: AllocationProfiler.cpp
+ подменяет глобальный operator new (заголовок 16 байт и счетчики на каждое выделение), и без опции замеры не платят за это.
+
+ Сборка в Linux: cmake -S . -B build -DCMAKE_BUILD_TYPE=Release [-DBENCHMARK_ALLOCATIONS=ON] && cmake --build build --target benchmark
+ Запуск: ./build/benchmark [--json results.json] [--csv results.csv] [--filter split] [--repetitions 15] [--warmup 3] [--group-by-rows 1048576]
+ */
+
+namespace
+{
+#if BENCHMARK_ALLOCATIONS
+    /// Число выделений памяти за один вызов function
+    template<typename TFunction>
+    double CountAllocations(TFunction&& function)
+    {
+        allocation_profiler::Scope scope("benchmark");
+        function();
+        return static_cast<double>(scope.counters().allocations);
+    }
+
+    /// Байты в куче, которые удерживает результат function, пока он жив
+    template<typename TFunction>
+    int64_t RetainedBytes(TFunction&& function)
+    {
+        allocation_profiler::Scope scope("benchmark");
+        auto result = function();
+        return scope.counters().live_bytes;
+    }
+#endif
+
+    struct Suite
+    {
+        benchmark::Runner runner;
+        std::string filter;
+
+        /// Проходит ли замер фильтр --filter (по группе или имени)
+        bool Matches(std::string_view group, std::string_view name = {}) const
+        {
+            return filter.empty() || group.find(filter) != std::string_view::npos || name.find(filter) != std::string_view::npos;
+        }
+
+        template<typename TFunction>
+        void Run(std::string_view group, std::string_view name, size_t size, TFunction&& function)
+        {
+            if (!Matches(group, name))
+                return;
+
+            benchmark::Result& result = runner.Run(group, name, size, function);
+#if BENCHMARK_ALLOCATIONS
+            result.allocations = CountAllocations(function);
+#endif
+            benchmark::WriteTable(std::cout, result);
+        }
+
+        /// setup() - перед каждой итерацией, вне замера
+        template<typename TSetup, typename TFunction>
+        void Run(std::string_view group, std::string_view name, size_t size, TSetup&& setup, TFunction&& function)
+        {
+            if (!Matches(group, name))
+                return;
+
+            benchmark::Result& result = runner.Run(group, name, size, setup, function);
+#if BENCHMARK_ALLOCATIONS
+            setup();
+            result.allocations = CountAllocations(function);
+#endif
+            benchmark::WriteTable(std::cout, result);
+        }
+    };
+
+    /// threads потоков запускаются один раз, Run(task) выполняет task(thread) во всех и ждет завершения: замер не включает создание потоков
+    class WorkerPool
+    {
+    public:
+        explicit WorkerPool(size_t threads) : _start(static_cast<std::ptrdiff_t>(threads + 1)), _finish(static_cast<std::ptrdiff_t>(threads + 1))
+        {
+            for (size_t t = 0; t < threads; ++t)
+            {
+                _threads.emplace_back([this, t]()
+                {
+                    while (true)
+                    {
+                        _start.arrive_and_wait();
+                        if (_stop)
+                            return;
+                        _task(t);
+                        _finish.arrive_and_wait();
+                    }
+                });
+            }
+        }
+
+        ~WorkerPool()
+        {
+            _stop = true;
+            _start.arrive_and_wait();
+            for (auto& thread : _threads)
+                thread.join();
+        }
+
+        WorkerPool(const WorkerPool&) = delete;
+        WorkerPool& operator=(const WorkerPool&) = delete;
+
+        size_t size() const noexcept { return _threads.size(); }
+
+        void Run(std::function<void(size_t)> task)
+        {
+            _task = std::move(task); // барьер публикует _task и _stop для потоков
+            _start.arrive_and_wait();
+            _finish.arrive_and_wait();
+        }
+
+    private:
+        std::barrier<> _start;
+        std::barrier<> _finish;
+        std::function<void(size_t)> _task;
+        bool _stop = false;
+        std::vector<std::thread> _threads;
+    };
+
+    /// 1, 2, 4, ... до hardware_concurrency (и само hardware_concurrency)
+    std::vector<size_t> ThreadCounts()
+    {
+        const size_t hardware = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+        std::vector<size_t> counts;
+        for (size_t threads = 1; threads < hardware; threads *= 2)
+            counts.push_back(threads);
+        counts.push_back(hardware);
+        return counts;
+    }
+
+    std::string MakeText(size_t words)
+    {
+        std::mt19937 generator(42);
+        std::string text;
+        for (size_t i = 0; i < words; ++i)
+        {
+            size_t length = 2 + generator() % 24; // короткие слова помещаются в SSO-буфер std::string, длинные - нет
+            for (size_t j = 0; j < length; ++j)
+                text += static_cast<char>('a' + generator() % 26);
+            text += ' ';
+        }
+        return text;
+    }
+
+    void Split(Suite& suite)
+    {
+        using namespace STRING_VIEW;
+        for (size_t words : {16, 1024, 65536})
+        {
+            const std::string text = MakeText(words);
+            suite.Run("split", "split_by_space_string", words, [&]()
+            {
+                benchmark::DoNotOptimize(split_by_space_string(text));
+            });
+            suite.Run("split", "split_by_space_string_view", words, [&]()
+            {
+                benchmark::DoNotOptimize(split_by_space_string_view(text));
+            });
+            const containers::shared_string shared(text);
+            suite.Run("split", "split_by_space_shared_slice", words, [&]()
+            {
+                benchmark::DoNotOptimize(split_by_space_shared_slice(shared));
+            });
+
+#if BENCHMARK_ALLOCATIONS
+            // Память результата: копии слов против срезов (буфер shared_string общий и уже выделен, как и text для string_view)
+            if (suite.Matches("split", "split_by_space"))
+                std::cout << "split retained bytes (" << words << " words): string " << RetainedBytes([&]() { return split_by_space_string(text); })
+                          << ", string_view " << RetainedBytes([&]() { return split_by_space_string_view(text); })
+                          << ", shared_slice " << RetainedBytes([&]() { return split_by_space_shared_slice(shared); }) << std::endl;
+#endif
+        }
+    }
+
+    /// Разбиение коротких строк протокола: std::vector против small_vector<std::string_view, 8> (выделения - при BENCHMARK_ALLOCATIONS)
+    void SmallVector(Suite& suite)
+    {
+        using namespace STRING_VIEW;
+        const std::string_view lines[] = {"GET /index.html HTTP/1.1 ", "PING 42 ", "QUIT "}; // split_by_space_string_view не выдает слово после последнего пробела
+        auto run = [&](std::string_view name, auto container)
+        {
+            suite.Run("small_vector split", name, std::size(lines), [&]()
+            {
+                size_t tokens = 0;
+                for (std::string_view line : lines)
+                {
+                    decltype(container) result;
+                    split_by_space_string_view(line, result);
+                    tokens += result.size();
+                }
+                benchmark::DoNotOptimize(tokens);
+            });
+        };
+        run("std::vector<std::string_view>", std::vector<std::string_view>());
+        run("small_vector<std::string_view, 8>", containers::small_vector<std::string_view, 8>());
+    }
+
+    void ToChars(Suite& suite)
+    {
+        for (size_t count : {1, 1024})
+        {
+            std::mt19937 generator(42);
+            std::vector<int> numbers(count);
+            for (int& number : numbers)
+                number = static_cast<int>(generator());
+
+            suite.Run("to_string/to_chars", "std::to_string", count, [&]()
+            {
+                size_t length = 0;
+                for (int number : numbers)
+                    length += std::to_string(number).size();
+                benchmark::DoNotOptimize(length);
+            });
+            suite.Run("to_string/to_chars", "std::to_chars", count, [&]()
+            {
+                size_t length = 0;
+                std::array<char, 16> buffer;
+                for (int number : numbers)
+                    length += std::to_chars(buffer.data(), buffer.data() + buffer.size(), number).ptr - buffer.data();
+                benchmark::DoNotOptimize(length);
+            });
+        }
+    }
+
+    void AnyVariant(Suite& suite)
+    {
+        for (size_t count : {16, 1024})
+        {
+            suite.Run("any/variant", "std::any", count, [&]()
+            {
+                std::vector<std::any> values;
+                values.reserve(count);
+                for (size_t i = 0; i < count; ++i)
+                {
+                    if (i % 3 == 0)
+                        values.emplace_back(static_cast<int>(i));
+                    else if (i % 3 == 1)
+                        values.emplace_back(static_cast<double>(i));
+                    else
+                        values.emplace_back(std::array<char, 32>{});
+                }
+                double sum = 0;
+                for (const auto& value : values)
+                {
+                    if (auto number = std::any_cast<int>(&value))
+                        sum += *number;
+                    else if (auto real = std::any_cast<double>(&value))
+                        sum += *real;
+                }
+                benchmark::DoNotOptimize(sum);
+            });
+            suite.Run("any/variant", "std::variant", count, [&]()
+            {
+                std::vector<std::variant<int, double, std::array<char, 32>>> values;
+                values.reserve(count);
+                for (size_t i = 0; i < count; ++i)
+                {
+                    if (i % 3 == 0)
+                        values.emplace_back(static_cast<int>(i));
+                    else if (i % 3 == 1)
+                        values.emplace_back(static_cast<double>(i));
+                    else
+                        values.emplace_back(std::array<char, 32>{});
+                }
+                double sum = 0;
+                for (const auto& value : values)
+                {
+                    if (auto number = std::get_if<int>(&value))
+                        sum += *number;
+                    else if (auto real = std::get_if<double>(&value))
+                        sum += *real;
+                }
+                benchmark::DoNotOptimize(sum);
+            });
+        }
+    }
+
+    template<typename T>
+    void Square(Suite& suite, std::string_view type)
+    {
+        using namespace SFINAE;
+        for (size_t count : {1024, 65536})
+        {
+            std::vector<T> values(count, T(3));
+            auto Run = [&](std::string_view name, auto square)
+            {
+                suite.Run("Square<" + std::string(type) + ">", name, count, [&]()
+                {
+                    T sum {0};
+                    for (const T& value : values)
+                    {
+                        if constexpr (std::is_arithmetic_v<T>)
+                            sum += square(value);
+                        else
+                            sum.value += square(value).value;
+                    }
+                    benchmark::DoNotOptimize(sum);
+                });
+            };
+            Run("ENABLE_IF::Square", [](const T& value) { return ENABLE_IF::Square(value); });
+            Run("CONSTEXPR::Square", [](const T& value) { return CONSTEXPR::Square(value); });
+            Run("CONCEPT::Square", [](const T& value) { return CONCEPT::Square(value); });
+        }
+    }
+
+    template<typename T>
+    void SquareBatch(Suite& suite, std::string_view type)
+    {
+        using namespace SFINAE;
+        for (size_t count : {size_t(1) << 10, size_t(1) << 20, size_t(100'000'000)})
+        {
+            std::vector<T> values(count, T(3));
+            std::vector<T> result(count, T(0));
+            std::string group = "Square(std::span<" + std::string(type) + ">)";
+
+            suite.Run(group, "per element", count, [&]()
+            {
+                for (size_t i = 0; i < count; ++i)
+                    result[i] = CONCEPT::Square(values[i]);
+                benchmark::DoNotOptimize(result.data());
+            });
+            suite.Run(group, "batch", count, [&]()
+            {
+                CONCEPT::Square(std::span<const T>(values), std::span<T>(result));
+                benchmark::DoNotOptimize(result.data());
+            });
+        }
+    }
+
+    void Contention(Suite& suite)
+    {
+        constexpr size_t increments = 10'000;
+        std::atomic<int64_t> shared {0};
+        metrics::Counter counter("benchmark.counter");
+        metrics::Histogram histogram("benchmark.histogram");
+
+        for (size_t threads = 1; threads <= 64; threads *= 2)
+        {
+            WorkerPool pool(threads); // потоки создаются вне замера, итерация - только инкременты
+            auto Run = [&](std::string_view name, auto increment)
+            {
+                suite.Run("contention", name, threads, [&]()
+                {
+                    pool.Run([&](size_t)
+                    {
+                        for (size_t i = 0; i < increments; ++i)
+                            increment(i);
+                    });
+                });
+            };
+            Run("std::atomic", [&](size_t) { shared.fetch_add(1, std::memory_order_relaxed); });
+            Run("metrics::Counter", [&](size_t) { counter.Increment(); });
+            Run("metrics::Histogram::Record", [&](size_t i) { histogram.Record(i); });
+        }
+    }
+
+    /// Поиск по size случайным ключам uint32_t, ~50% промахов: std::map против flat_map (Sorted и Eytzinger)
+    void FlatMap(Suite& suite)
+    {
+        constexpr size_t lookups = 1 << 20;
+        for (size_t size : {size_t(1'000), size_t(1'000'000), size_t(100'000'000)})
+        {
+            const std::string group = "flat_map " + std::to_string(size) + " keys";
+            if (!suite.Matches(group))
+                continue; // 100M ключей строятся десятки секунд
+
+            std::mt19937 generator(42);
+            std::vector<std::pair<uint32_t, uint32_t>> items(size);
+            for (auto& [key, value] : items)
+                key = value = static_cast<uint32_t>(generator());
+
+            std::vector<uint32_t> queries(lookups);
+            for (auto& query : queries)
+                query = (generator() & 1) ? items[generator() % size].first : static_cast<uint32_t>(generator());
+
+            auto run = [&](std::string_view name, const auto& map)
+            {
+                suite.Run(group, name, lookups, [&]()
+                {
+                    size_t found = 0;
+                    for (uint32_t query : queries)
+                        found += map.find(query) != map.end();
+                    benchmark::DoNotOptimize(found);
+                });
+            };
+
+            // узел std::map<uint32_t, uint32_t> - ~48 байт: 100M ключей не помещаются в память машины с 8 ГБ и меньше
+            const size_t map_bytes = size * 48;
+#if defined(__linux__)
+            const bool fits = map_bytes < static_cast<size_t>(sysconf(_SC_PHYS_PAGES)) * static_cast<size_t>(sysconf(_SC_PAGESIZE)) / 2;
+#else
+            const bool fits = true;
+#endif
+            if (fits)
+            {
+                std::map<uint32_t, uint32_t> map(items.begin(), items.end());
+                run("std::map::find", map);
+            }
+            else
+            {
+                std::cout << group << ": std::map needs ~" << (map_bytes >> 30) << " GB, skipped" << std::endl;
+            }
+            run("flat_map<Sorted>::find", containers::flat_map<uint32_t, uint32_t>(items));
+            run("flat_map<Eytzinger>::find", containers::flat_map<uint32_t, uint32_t, std::less<>, containers::Layout::Eytzinger>(items));
+        }
+    }
+
+    /*
+     Мемоизация поиска: lookup_cache::ShardedClockCache::get_or_compute против std::unordered_map под одним мьютексом, 1M поисков по 100'000 ключей
+     (распределение Ципфа), емкость кэша - 10'000, в 1..hardware_concurrency потоках (size - число потоков, потоки создаются вне замера).
+     Кэш живет между итерациями: замеряется установившийся режим с вытеснением, после прогонов выводятся попадания и совмещенные промахи.
+     */
+    void LookupCache(Suite& suite)
+    {
+        constexpr size_t capacity = 10'000;
+        constexpr size_t keys = 100'000;
+        constexpr size_t lookups = 1'000'000;
+        if (!suite.Matches("lookup_cache"))
+            return;
+
+        std::vector<std::string> names(keys);
+        for (size_t i = 0; i < keys; ++i)
+            names[i] = "key" + std::to_string(i);
+        std::vector<uint32_t> workload(lookups);
+        {
+            std::mt19937 generator(42);
+            lookup_cache::ZipfDistribution zipf(keys);
+            for (auto& index : workload)
+                index = static_cast<uint32_t>(zipf(generator));
+        }
+        auto compute = [](std::string_view key) { return std::hash<std::string_view>()(key); };
+
+        for (size_t threads : ThreadCounts())
+        {
+            WorkerPool pool(threads);
+            auto run = [&](std::string_view name, auto&& lookup)
+            {
+                suite.Run("lookup_cache", name, threads, [&]()
+                {
+                    pool.Run([&](size_t thread)
+                    {
+                        size_t sum = 0;
+                        for (size_t i = thread; i < workload.size(); i += threads)
+                            sum += lookup(names[workload[i]]);
+                        benchmark::DoNotOptimize(sum);
+                    });
+                });
+            };
+
+            lookup_cache::ShardedClockCache<size_t> cache(capacity);
+            run("ShardedClockCache::get_or_compute", [&](std::string_view key) { return cache.get_or_compute(key, compute); });
+            auto statistics = cache.statistics();
+            std::cout << "lookup_cache, " << threads << " threads: hits " << statistics.hits << ", misses " << statistics.misses
+                      << ", evictions " << statistics.evictions << ", coalesced " << statistics.coalesced << std::endl;
+
+            std::mutex mutex;
+            std::unordered_map<std::string, size_t> map;
+            run("std::mutex + std::unordered_map", [&](std::string_view key)
+            {
+                std::scoped_lock lock(mutex);
+                std::string string(key);
+                if (auto it = map.find(string); it != map.end())
+                    return it->second;
+                return map[string] = compute(key);
+            });
+        }
+    }
+
+    void Queues(Suite& suite)
+    {
+        constexpr size_t items = 100'000;
+        constexpr size_t capacity = 1024;
+        static constexpr size_t batch = 64;
+
+        auto Push = [](auto& queue, size_t count)
+        {
+            for (size_t i = 0; i < count; ++i)
+                queue.push(i);
+        };
+        auto Pop = [](auto& queue, size_t count)
+        {
+            uint64_t sum = 0;
+            for (size_t i = 0; i < count; ++i)
+                sum += queue.pop();
+            benchmark::DoNotOptimize(sum);
+        };
+        auto PushBatch = [](auto& queue, size_t count)
+        {
+            uint64_t values[batch];
+            for (size_t i = 0; i < count;)
+            {
+                size_t n = std::min(batch, count - i);
+                for (size_t j = 0; j < n; ++j)
+                    values[j] = i + j;
+                for (size_t pushed = 0; pushed < n;)
+                {
+                    size_t done = queue.try_push_n(values + pushed, n - pushed);
+                    if (!done)
+                        std::this_thread::yield();
+                    pushed += done;
+                }
+                i += n;
+            }
+        };
+        auto PopBatch = [](auto& queue, size_t count)
+        {
+            uint64_t values[batch];
+            uint64_t sum = 0;
+            for (size_t i = 0; i < count;)
+            {
+                size_t n = queue.try_pop_n(values, std::min(batch, count - i));
+                if (!n)
+                    std::this_thread::yield();
+                for (size_t j = 0; j < n; ++j)
+                    sum += values[j];
+                i += n;
+            }
+            benchmark::DoNotOptimize(sum);
+        };
+
+        // Один прогон: items элементов от producers производителей к consumers потребителям
+        auto Throughput = [&](std::string_view name, size_t producers, size_t consumers, auto& queue, auto produce, auto consume)
+        {
+            std::string label = std::string(name) + " (" + std::to_string(producers) + "P/" + std::to_string(consumers) + "C)";
+            suite.Run("queue throughput", label, items, [&]()
+            {
+                std::vector<std::thread> threads;
+                for (size_t p = 0; p < producers; ++p)
+                    threads.emplace_back([&, p]() { produce(queue, items / producers + (p < items % producers)); });
+                for (size_t c = 0; c < consumers; ++c)
+                    threads.emplace_back([&, c]() { consume(queue, items / consumers + (c < items % consumers)); });
+                for (auto& thread : threads)
+                    thread.join();
+            });
+        };
+        {
+            concurrent::SpscRing<uint64_t, true> ring(capacity);
+            Throughput("SpscRing push/pop", 1, 1, ring, Push, Pop);
+            Throughput("SpscRing try_push_n/try_pop_n", 1, 1, ring, PushBatch, PopBatch);
+        }
+        {
+            concurrent::MpmcQueue<uint64_t, true> queue(capacity);
+            Throughput("MpmcQueue push/pop", 1, 1, queue, Push, Pop);
+            Throughput("MpmcQueue push/pop", 2, 2, queue, Push, Pop);
+            Throughput("MpmcQueue try_push_n/try_pop_n", 2, 2, queue, PushBatch, PopBatch);
+        }
+        {
+            concurrent::MutexQueue<uint64_t> queue(capacity);
+            Throughput("MutexQueue push/pop", 1, 1, queue, Push, Pop);
+            Throughput("MutexQueue push/pop", 2, 2, queue, Push, Pop);
+        }
+
+        // Задержка: эхо-поток отвечает на каждое сообщение до стоп-значения, итерация - один круг
+        auto PingPong = [&](std::string_view name, auto& there, auto& back)
+        {
+            constexpr uint64_t stop = ~uint64_t(0);
+            std::thread echo([&]()
+            {
+                for (uint64_t value; (value = there.pop()) != stop;)
+                    back.push(value);
+            });
+            uint64_t round = 0;
+            suite.Run("queue round trip", name, 1, [&]()
+            {
+                there.push(round++);
+                benchmark::DoNotOptimize(back.pop());
+            });
+            there.push(stop);
+            echo.join();
+        };
+        {
+            concurrent::SpscRing<uint64_t, true> there(capacity), back(capacity);
+            PingPong("SpscRing", there, back);
+        }
+        {
+            concurrent::MutexQueue<uint64_t> there(capacity), back(capacity);
+            PingPong("MutexQueue", there, back);
+        }
+    }
+
+    void Encoding(Suite& suite)
+    {
+        using namespace encoding;
+        for (size_t size : {size_t(4) << 10, size_t(4) << 20})
+        {
+            for (double ascii_share : {0.1, 1.0})
+            {
+                const std::string group = ascii_share < 1 ? "encoding russian" : "encoding ascii";
+                const std::string utf8 = MakeRussianText(size, ascii_share);
+                std::vector<char> cp1251(utf8.size());
+                cp1251.resize(Utf8ToCp1251(utf8, cp1251).written);
+                const std::string_view cp1251_text(cp1251.data(), cp1251.size());
+                std::vector<char> out(MaxUtf8Size(utf8.size()));
+
+                suite.Run(group, "SCALAR::Cp1251ToUtf8", cp1251.size(), [&]() { benchmark::DoNotOptimize(SCALAR::Cp1251ToUtf8(cp1251_text, out)); });
+                suite.Run(group, "Cp1251ToUtf8", cp1251.size(), [&]() { benchmark::DoNotOptimize(Cp1251ToUtf8(cp1251_text, out)); });
+                suite.Run(group, "SCALAR::Utf8ToCp1251", utf8.size(), [&]() { benchmark::DoNotOptimize(SCALAR::Utf8ToCp1251(utf8, out)); });
+                suite.Run(group, "Utf8ToCp1251", utf8.size(), [&]() { benchmark::DoNotOptimize(Utf8ToCp1251(utf8, out)); });
+                suite.Run(group, "SCALAR::ValidateUtf8", utf8.size(), [&]() { benchmark::DoNotOptimize(SCALAR::ValidateUtf8(utf8)); });
+                suite.Run(group, "ValidateUtf8", utf8.size(), [&]() { benchmark::DoNotOptimize(ValidateUtf8(utf8)); });
+            }
+        }
+    }
+
+    void MultiSearch(Suite& suite)
+    {
+        using namespace search;
+        std::vector<std::string> small = {"ERROR", "WARN", "refused", "timeout", "panic", "id=", "fatal", "denied"};
+        std::vector<std::string> large = small;
+        for (size_t i = 0; large.size() < 64; ++i)
+            large.push_back("key=" + std::to_string(i * 37 % 10000));
+
+        for (size_t size : {size_t(64) << 10, size_t(4) << 20})
+        {
+            const std::string log = MakeLog(size);
+            for (const auto* patterns : {&small, &large})
+            {
+                const std::string group = "search " + std::to_string(patterns->size()) + " patterns";
+                suite.Run(group, "Naive", log.size(), [&]() { benchmark::DoNotOptimize(Naive(*patterns, log).size()); });
+                for (Engine engine : {Engine::Teddy, Engine::AhoCorasick})
+                {
+                    if (engine == Engine::Teddy && patterns->size() > Searcher::teddy_limit)
+                        continue;
+                    Searcher searcher(*patterns, engine);
+                    suite.Run(group, engine == Engine::Teddy ? "Teddy" : "AhoCorasick", log.size(), [&]()
+                    {
+                        size_t count = 0;
+                        searcher.FindAll(log, [&count](const Match&) { ++count; });
+                        benchmark::DoNotOptimize(count);
+                    });
+                }
+            }
+        }
+    }
+
+    /// Запись с тремя строками, как Person в main.cpp: обмен при сортировке перемещает все три
+    struct Person
+    {
+        std::string name;
+        uint32_t age = 0;
+        std::string city;
+        std::string country;
+    };
+
+    void Radix(Suite& suite)
+    {
+        constexpr size_t count = 100'000;
+        const size_t threads = std::thread::hardware_concurrency();
+        std::mt19937 generator(42);
+        constexpr std::string_view syllables[] = {"an", "na", "va", "iv", "ma", "ri", "ol", "ga", "se", "rg", "ei", "dm"};
+        std::vector<Person> persons(count);
+        for (Person& person : persons)
+        {
+            for (size_t i = 0, length = 2 + generator() % 4; i < length; ++i)
+                person.name += syllables[generator() % std::size(syllables)];
+            person.age = static_cast<uint32_t>(generator() % 100);
+            person.city = "Moscow";
+            person.country = "Russia";
+        }
+
+        auto name = [](const Person& person) -> const std::string& { return person.name; };
+        auto less = [](const Person& left, const Person& right)
+        {
+            return left.age != right.age ? left.age < right.age : left.name < right.name;
+        };
+        auto same = [](const Person& left, const Person& right) { return left.age == right.age && left.name == right.name; };
+        std::vector<Person> expected = persons;
+        std::stable_sort(expected.begin(), expected.end(), less);
+        std::vector<Person> expected_by_name = persons;
+        std::stable_sort(expected_by_name.begin(), expected_by_name.end(), [](const Person& left, const Person& right) { return left.name < right.name; });
+
+        auto check = [](std::string_view title, bool valid)
+        {
+            if (!valid)
+                std::cerr << "radix: " << title << ": order mismatch" << std::endl;
+        };
+
+        // Каждая итерация сортирует свежую копию: время копии - отдельной строкой
+        std::vector<Person> sorted;
+        suite.Run("radix sort", "copy", count, [&]() { sorted = persons; });
+        auto run = [&](std::string_view title, auto sort)
+        {
+            sorted = persons;
+            sort(sorted);
+            check(title, std::equal(sorted.begin(), sorted.end(), expected.begin(), expected.end(), same));
+            suite.Run("radix sort", title, count, [&]()
+            {
+                sorted = persons;
+                sort(sorted);
+            });
+        };
+        run("std::stable_sort", [&](std::vector<Person>& items) { std::stable_sort(items.begin(), items.end(), less); });
+        run("std::sort", [&](std::vector<Person>& items) { std::sort(items.begin(), items.end(), less); });
+#if BENCHMARK_PARALLEL_STL
+        run("std::sort(par)", [&](std::vector<Person>& items) { std::sort(std::execution::par, items.begin(), items.end(), less); });
+        run("std::stable_sort(par)", [&](std::vector<Person>& items) { std::stable_sort(std::execution::par, items.begin(), items.end(), less); });
+#endif
+        run("radix::SortIndices + Permute, 1 thread", [&](std::vector<Person>& items) { radix::Permute(items, radix::SortIndices(items, &Person::age, name, 1)); });
+        if (threads > 1)
+            run("radix::SortIndices + Permute, " + std::to_string(threads) + " threads", [&](std::vector<Person>& items)
+            {
+                radix::Permute(items, radix::SortIndices(items, &Person::age, name, threads));
+            });
+
+        // Только по name: сравнения строк против MSD (radix возвращает индексы и записи не копирует)
+        suite.Run("radix sort by name", "std::stable_sort", count, [&]()
+        {
+            sorted = persons;
+            std::stable_sort(sorted.begin(), sorted.end(), [](const Person& left, const Person& right) { return left.name < right.name; });
+        });
+        std::vector<radix::Index> order = radix::SortIndicesByString(persons, name, threads);
+        bool valid = order.size() == count;
+        for (size_t i = 0; valid && i < count; ++i)
+            valid = persons[order[i]].name == expected_by_name[i].name;
+        check("radix::SortIndicesByString", valid);
+        suite.Run("radix sort by name", "radix::SortIndicesByString", count, [&]()
+        {
+            benchmark::DoNotOptimize(radix::SortIndicesByString(persons, name, threads).data());
+        });
+
+        // Top-k: малое k и 10% записей
+        for (size_t k : {size_t(100), count / 10})
+        {
+            const std::string group = "radix top-" + std::to_string(k);
+            std::vector<radix::Index> top = radix::TopK(persons, k, &Person::age, name, threads);
+            valid = top.size() == k;
+            for (size_t i = 0; valid && i < k; ++i)
+                valid = same(persons[top[i]], expected[i]);
+            check(group, valid);
+
+            suite.Run(group, "std::partial_sort", count, [&]()
+            {
+                sorted = persons;
+                std::partial_sort(sorted.begin(), sorted.begin() + static_cast<std::ptrdiff_t>(k), sorted.end(), less);
+            });
+            suite.Run(group, "radix::TopK", count, [&]()
+            {
+                benchmark::DoNotOptimize(radix::TopK(persons, k, &Person::age, name, threads).data());
+            });
+        }
+    }
+
+    /*
+     Сумма, среднее и норма 1M чисел из текста (~18 МБ): pipeline::RunMaterialized (весь текст в памяти, затем split и from_chars)
+     против pipeline::Run (корутины и каналы, куски по 64 КБ) в ThreadPool из 1..hardware_concurrency потоков (size - число чисел).
+     Задержка до первого промежуточного результата конвейера выводится отдельно: материализация выдает результат только в конце.
+     */
+    void Pipeline(Suite& suite)
+    {
+        constexpr size_t count = 1'000'000;
+        if (!suite.Matches("pipeline"))
+            return;
+
+        std::string text;
+        {
+            std::mt19937 generator(42);
+            std::uniform_real_distribution<double> distribution(-1000, 1000);
+            char buffer[32];
+            for (size_t i = 0; i < count; ++i)
+            {
+                text.append(buffer, std::to_chars(buffer, buffer + sizeof(buffer), distribution(generator)).ptr);
+                text += ' ';
+            }
+        }
+
+        std::istringstream materialized_in(text);
+        const pipeline::Aggregate expected = pipeline::RunMaterialized(materialized_in);
+        if (expected.count != count)
+            std::cerr << "pipeline: RunMaterialized read " << expected.count << " numbers of " << count << std::endl;
+        suite.Run("pipeline", "RunMaterialized", count, [&]()
+        {
+            std::istringstream in(text);
+            benchmark::DoNotOptimize(pipeline::RunMaterialized(in).count);
+        });
+
+        for (size_t threads : ThreadCounts())
+        {
+            pipeline::ThreadPool pool(threads);
+            const std::string name = "Run, " + std::to_string(threads) + (threads == 1 ? " thread" : " threads");
+
+            // Проверка и задержка до первого результата - один прогон вне замера
+            std::istringstream in(text);
+            std::optional<double> first_result;
+            const auto start = std::chrono::steady_clock::now();
+            const pipeline::Aggregate streamed = pipeline::Run(in, pool, {}, [&](const pipeline::Aggregate&)
+            {
+                if (!first_result)
+                    first_result = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            });
+            if (streamed.count != expected.count)
+                std::cerr << "pipeline: " << name << ": count mismatch" << std::endl;
+            if (first_result && suite.Matches("pipeline", name))
+                std::cout << "pipeline: " << name << " first result after " << *first_result << " ms" << std::endl;
+
+            suite.Run("pipeline", name, count, [&]()
+            {
+                std::istringstream in(text);
+                benchmark::DoNotOptimize(pipeline::Run(in, pool).count);
+            });
+        }
+    }
+
+    /// rows строк за итерацию: пакет из 1M строк подается повторно (100M строк - 100 раз в один Query), как поток пакетов из источника
+    void GroupBy(Suite& suite, size_t rows)
+    {
+        using namespace group_by;
+        struct Visit
+        {
+            std::string_view city;
+            uint32_t age;
+        };
+        constexpr auto city = [](const Visit& visit) { return visit.city; };
+        using Query = group_by::GroupBy<city, Count, Average<&Visit::age>>;
+        using State = Aggregates<Count, Average<&Visit::age>>::State;
+
+        struct Distribution
+        {
+            std::string_view name;
+            size_t distinct;
+            double skew; // 0 - равномерно
+            size_t max_groups;
+        };
+        const Distribution distributions[] = {
+            {"uniform, 1'000 keys", 1'000, 0, 1 << 20},
+            {"zipf 1.1, 100'000 keys", 100'000, 1.1, 1 << 20},
+            {"zipf 0.7, 2'000'000 keys", 2'000'000, 0.7, 1 << 18},
+        };
+        const size_t batch_rows = std::min<size_t>(rows, 1 << 20);
+        const size_t threads = std::thread::hardware_concurrency();
+
+        for (const Distribution& distribution : distributions)
+        {
+            std::vector<std::string> keys(distribution.distinct);
+            for (size_t i = 0; i < keys.size(); ++i)
+                keys[i] = "city_" + std::to_string(i * 2654435761u % 1'000'000'007u);
+
+            std::vector<double> weights(keys.size());
+            for (size_t i = 0; i < weights.size(); ++i)
+                weights[i] = distribution.skew == 0 ? 1.0 : 1.0 / std::pow(static_cast<double>(i + 1), distribution.skew);
+            std::discrete_distribution<size_t> pick(weights.begin(), weights.end());
+            std::mt19937 generator(42);
+            std::vector<Visit> batch(batch_rows);
+            for (Visit& visit : batch)
+                visit = {keys[pick(generator)], static_cast<uint32_t>(generator() % 100)};
+
+            const std::string group = "group_by " + std::string(distribution.name);
+            // пакеты до rows строк: последний - неполный
+            auto replay = [&](auto add)
+            {
+                for (size_t done = 0; done < rows; done += batch.size())
+                    add(std::span<const Visit>(batch).first(std::min(batch.size(), rows - done)));
+            };
+
+            suite.Run(group, "std::map<std::string, ...>", rows, [&]()
+            {
+                std::map<std::string, State> map;
+                replay([&](std::span<const Visit> visits)
+                {
+                    for (const Visit& visit : visits)
+                        Aggregates<Count, Average<&Visit::age>>::Add(map[std::string(visit.city)], visit);
+                });
+                benchmark::DoNotOptimize(map.size());
+            });
+
+            std::vector<size_t> thread_counts = {1};
+            if (threads > 1)
+                thread_counts.push_back(threads);
+            for (size_t count : thread_counts)
+            {
+                Options options;
+                options.threads = count;
+                options.max_groups = distribution.max_groups;
+                const std::string title = "group_by::GroupBy, " + std::to_string(count) + (count == 1 ? " thread" : " threads");
+
+                if (!suite.Matches(group, title))
+                    continue;
+
+                // Проверка суммы и объема сброса - один раз вне замера
+                Query check(options);
+                replay([&](std::span<const Visit> visits) { check.Add(visits); });
+                uint64_t sum = 0;
+                Stats stats = check.Finish([&sum](std::string_view, uint64_t count, double) { sum += count; });
+                if (sum != rows)
+                    std::cerr << group << ": " << title << ": count mismatch" << std::endl;
+                if (stats.spilled_groups)
+                    std::cout << group << ": " << title << " spilled " << (stats.spilled_bytes >> 20) << " MB" << std::endl;
+
+                suite.Run(group, title, rows, [&]()
+                {
+                    Query query(options);
+                    replay([&](std::span<const Visit> visits) { query.Add(visits); });
+                    uint64_t groups = 0;
+                    query.Finish([&groups](std::string_view, uint64_t, double) { ++groups; });
+                    benchmark::DoNotOptimize(groups);
+                });
+            }
+        }
+    }
+
+    void Membership(Suite& suite)
+    {
+        using namespace membership;
+        using Registry = std::map<std::string, std::any, std::less<>>;
+        constexpr size_t keys = 100'000;
+        constexpr size_t lookups = 1 << 16;
+        Registry registry;
+        for (size_t i = 0; i < keys; ++i)
+            registry.emplace("service.option." + std::to_string(i), static_cast<int>(i));
+
+        const Filtered<Registry, BloomFilter> bloom(registry, BloomFilter(keys, 0.01));
+        const Filtered<Registry, CuckooFilter<uint16_t>> cuckoo(registry, CuckooFilter<uint16_t>(keys));
+
+        std::mt19937 generator(42);
+        for (double hit_rate : {0.0, 0.1, 0.5, 0.9})
+        {
+            std::vector<std::string> queries(lookups);
+            for (std::string& query : queries)
+            {
+                // промах - ключ вне реестра с тем же префиксом: поиск в map проходит дерево до листа
+                const size_t number = generator() % keys;
+                query = "service.option." + std::to_string(std::uniform_real_distribution<>(0, 1)(generator) < hit_rate ? number : keys + number);
+            }
+
+            const std::string group = "membership hit rate " + std::to_string(static_cast<int>(hit_rate * 100)) + "%";
+            auto run = [&](std::string_view name, auto find)
+            {
+                size_t found = 0;
+                for (const std::string& query : queries)
+                    found += find(std::string_view(query));
+                suite.Run(group, name, lookups, [&]()
+                {
+                    size_t count = 0;
+                    for (const std::string& query : queries)
+                        count += find(std::string_view(query));
+                    benchmark::DoNotOptimize(count);
+                });
+                return found;
+            };
+            const size_t expected = run("std::map::find", [&](std::string_view key) { return registry.find(key) != registry.end(); });
+            const bool same = run("Filtered<BloomFilter>::find", [&](std::string_view key) { return bloom.find(key) != bloom.end(); }) == expected &&
+                              run("Filtered<CuckooFilter>::find", [&](std::string_view key) { return cuckoo.find(key) != cuckoo.end(); }) == expected;
+            if (!same)
+                std::cerr << group << ": Filtered result mismatch" << std::endl;
+        }
+
+        if (!suite.Matches("membership"))
+            return;
+        // доля ложных срабатываний на ключах, которых нет
+        size_t bloom_positives = 0, cuckoo_positives = 0;
+        const size_t probes = 1'000'000;
+        for (size_t i = 0; i < probes; ++i)
+        {
+            const std::string key = "absent." + std::to_string(i);
+            bloom_positives += bloom.filter().Contains(key);
+            cuckoo_positives += cuckoo.filter().Contains(key);
+        }
+        std::cout << "membership: BloomFilter 1% " << bloom.filter().memory() / 1024 << " KB, CuckooFilter<uint16_t> " << cuckoo.filter().memory() / 1024
+                  << " KB for " << keys << " keys; false positive rate: BloomFilter " << static_cast<double>(bloom_positives) / probes
+                  << ", CuckooFilter<uint16_t> " << static_cast<double>(cuckoo_positives) / probes
+                  << " (expected <= " << CuckooFilter<uint16_t>::FalsePositiveRate() << ")" << std::endl;
+    }
+
+#if defined(__linux__)
+    /// Вытеснение файла из кэша страниц ОС: следующее чтение идет с диска (грязные страницы сначала записываются - fsync)
+    bool Evict(const std::filesystem::path& path)
+    {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        bool done = fsync(fd) == 0 && posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+        close(fd);
+        return done;
+    }
+
+    /// Доля страниц файла в кэше страниц (mincore)
+    double Resident(const std::filesystem::path& path)
+    {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return 1;
+        const size_t size = std::filesystem::file_size(path);
+        const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        void* data = size ? mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+        close(fd);
+        if (data == MAP_FAILED)
+            return 1;
+        std::vector<unsigned char> pages((size + page - 1) / page);
+        size_t resident = 0;
+        if (mincore(data, size, pages.data()) == 0)
+        {
+            for (unsigned char flags : pages)
+                resident += flags & 1;
+        }
+        munmap(data, size);
+        return static_cast<double>(resident) / static_cast<double>(pages.size());
+    }
+#endif
+
+    /*
+     Загрузка 10M записей: бинарный файл через mmap (person_file::Reader) против текстового файла (строка "name age city country") с разбором.
+     Оба варианта читают каждый байт строк (хэш FNV-1a), а не только размеры из записей. "read (page-in)" - последовательное чтение
+     бинарного файла блоками по 1 МБ без разбора: нижняя граница холодного старта.
+     Холодный старт - файл вытесняется из кэша страниц перед каждой итерацией (fsync + posix_fadvise DONTNEED, только Linux),
+     теплый - файл уже в кэше после предыдущей итерации.
+     */
+    void PersonFile(Suite& suite)
+    {
+        constexpr size_t count = 10'000'000;
+        if (!suite.Matches("person_file"))
+            return;
+
+        const auto directory = std::filesystem::temp_directory_path();
+        const auto binary_path = directory / "benchmark_persons.bin";
+        const auto text_path = directory / "benchmark_persons.txt";
+        {
+            person_file::Writer writer(binary_path);
+            std::ofstream text(text_path);
+            for (size_t i = 0; i < count; ++i)
+            {
+                std::string name = "name" + std::to_string(i);
+                auto age = static_cast<uint32_t>(i % 100);
+                writer.Write(name, age, "Moscow", "Russia");
+                text << name << ' ' << age << ' ' << "Moscow" << ' ' << "Russia" << '\n';
+            }
+        }
+
+        auto hash = [](uint64_t hash, std::string_view text)
+        {
+            for (char c : text)
+                hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001b3;
+            return hash;
+        };
+        uint64_t checksum = 0;
+        auto page_in = [&]()
+        {
+            std::ifstream file(binary_path, std::ios::binary);
+            std::vector<char> buffer(1 << 20);
+            while (file.read(buffer.data(), static_cast<std::streamsize>(buffer.size())) || file.gcount())
+                checksum += static_cast<unsigned char>(buffer[0]);
+        };
+        auto mmap_load = [&](bool prefetch)
+        {
+            person_file::Reader reader(binary_path, prefetch);
+            for (size_t i = 0; i < reader.size(); ++i)
+            {
+                person_file::PersonView person = reader[i];
+                checksum = hash(hash(hash(checksum + person.age, person.name), person.loc.city), person.loc.country);
+            }
+        };
+        auto text_load = [&]()
+        {
+            std::ifstream text(text_path);
+            std::string name, city, country;
+            uint32_t age;
+            while (text >> name >> age >> city >> country)
+                checksum = hash(hash(hash(checksum + age, name), city), country);
+        };
+
+#if defined(__linux__)
+        Evict(binary_path);
+        if (Resident(binary_path) > 0.01)
+            std::cout << "person_file: posix_fadvise did not evict the file, cold start is measured warm" << std::endl;
+        auto evict_binary = [&]() { Evict(binary_path); };
+        auto evict_text = [&]() { Evict(text_path); };
+        suite.Run("person_file cold", "read (page-in)", count, evict_binary, page_in);
+        suite.Run("person_file cold", "person_file::Reader (mmap)", count, evict_binary, [&]() { mmap_load(false); });
+        suite.Run("person_file cold", "person_file::Reader (mmap, MADV_WILLNEED)", count, evict_binary, [&]() { mmap_load(true); });
+        suite.Run("person_file cold", "std::ifstream >> (text)", count, evict_text, text_load);
+#else
+        std::cout << "person_file: cold start needs posix_fadvise, only the warm start is measured" << std::endl;
+#endif
+        suite.Run("person_file warm", "read (page-in)", count, page_in);
+        suite.Run("person_file warm", "person_file::Reader (mmap)", count, [&]() { mmap_load(false); });
+        suite.Run("person_file warm", "std::ifstream >> (text)", count, text_load);
+        benchmark::DoNotOptimize(checksum);
+
+        std::filesystem::remove(binary_path);
+        std::filesystem::remove(text_path);
+    }
+
+    /*
+     Сериализация 1'000 записей с вложенной структурой: написанный вручную код против reflection::Serialize (обход полей декомпозицией)
+     и чтение reflection::Deserialize (строки - std::string_view на буфер). size - число записей, байты результата выводятся отдельно.
+     */
+    void Reflection(Suite& suite)
+    {
+        struct Location
+        {
+            std::string_view city;
+            std::string_view country;
+        };
+        struct Traveler
+        {
+            std::string_view name;
+            uint32_t age;
+            Location loc;
+        };
+        constexpr size_t count = 1'000;
+        std::vector<Traveler> items(count);
+        for (size_t i = 0; i < count; ++i)
+            items[i] = {i % 2 ? "Ivan" : "Maria Petrovna", static_cast<uint32_t>(i % 100), {"Moscow", "Russia"}};
+
+        auto handwritten = [](const Traveler& item, std::string& out)
+        {
+            reflection::WriteVarint(out, item.name.size());
+            out.append(item.name);
+            reflection::WriteVarint(out, item.age);
+            reflection::WriteVarint(out, item.loc.city.size());
+            out.append(item.loc.city);
+            reflection::WriteVarint(out, item.loc.country.size());
+            out.append(item.loc.country);
+        };
+
+        std::string out, expected;
+        for (const Traveler& item : items)
+            handwritten(item, expected);
+        for (const Traveler& item : items)
+            reflection::Serialize(item, out);
+        if (out != expected)
+            std::cerr << "reflection: Serialize differs from the handwritten serializer" << std::endl;
+
+        // буфер выделен заранее: замеряется кодирование, а не рост строки
+        suite.Run("reflection", "handwritten", count, [&]()
+        {
+            out.clear();
+            for (const Traveler& item : items)
+                handwritten(item, out);
+            benchmark::DoNotOptimize(out.data());
+        });
+        suite.Run("reflection", "reflection::Serialize", count, [&]()
+        {
+            out.clear();
+            for (const Traveler& item : items)
+                reflection::Serialize(item, out);
+            benchmark::DoNotOptimize(out.data());
+        });
+        suite.Run("reflection", "reflection::Deserialize", count, [&]()
+        {
+            Traveler value {};
+            std::from_chars_result result {expected.data(), std::errc()};
+            while (result.ptr != expected.data() + expected.size() && result.ec == std::errc())
+                result = reflection::Deserialize(result.ptr, expected.data() + expected.size(), value);
+            benchmark::DoNotOptimize(value);
+        });
+        if (suite.Matches("reflection"))
+            std::cout << "reflection: " << expected.size() << " bytes for " << count << " records" << std::endl;
+    }
+
+    void Trace(Suite& suite)
+    {
+        constexpr size_t scopes = 256;
+        suite.Run("trace", "empty loop", scopes, []()
+        {
+            for (size_t i = 0; i < scopes; ++i)
+                benchmark::DoNotOptimize(i);
+        });
+
+        trace::Start();
+        suite.Run("trace", "TRACE_SCOPE", scopes, []()
+        {
+            for (size_t i = 0; i < scopes; ++i)
+            {
+                TRACE_SCOPE("benchmark");
+                benchmark::DoNotOptimize(i);
+            }
+            trace::Discard();
+        });
+        trace::Stop();
+    }
+
+    /// Строки "name = value\n" в std::string: iostream, snprintf, std::format (если есть в стандартной библиотеке) и format::FormatTo
+    void Format(Suite& suite)
+    {
+        for (size_t count : {1, 1024})
+        {
+            std::mt19937 generator(42);
+            std::vector<std::pair<std::string, int>> values(count);
+            for (auto& [name, value] : values)
+            {
+                name = "value" + std::to_string(generator() % 1000);
+                value = static_cast<int>(generator());
+            }
+            std::string out;
+            out.reserve(count * 32);
+
+            std::ostringstream stream;
+            suite.Run("format", "std::ostringstream", count, [&]()
+            {
+                stream.str({});
+                for (const auto& [name, value] : values)
+                    stream << name << " = " << value << '\n';
+                benchmark::DoNotOptimize(stream.tellp());
+            });
+            suite.Run("format", "std::snprintf", count, [&]()
+            {
+                out.clear();
+                char buffer[64];
+                for (const auto& [name, value] : values)
+                    out.append(buffer, static_cast<size_t>(std::snprintf(buffer, sizeof(buffer), "%s = %d\n", name.c_str(), value)));
+                benchmark::DoNotOptimize(out.data());
+            });
+#if defined(__cpp_lib_format)
+            suite.Run("format", "std::format_to", count, [&]()
+            {
+                out.clear();
+                for (const auto& [name, value] : values)
+                    std::format_to(std::back_inserter(out), "{} = {}\n", name, value);
+                benchmark::DoNotOptimize(out.data());
+            });
+#endif
+            suite.Run("format", "format::FormatTo", count, [&]()
+            {
+                out.clear();
+                for (const auto& [name, value] : values)
+                    format::FormatTo<"{} = {}\n">(out, name, value);
+                benchmark::DoNotOptimize(out.data());
+            });
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    auto usage = [&]()
+    {
+        std::cerr << "usage: " << argv[0] << " [--json results.json] [--csv results.csv] [--filter split] [--repetitions 15] [--warmup 3] [--group-by-rows 1048576]" << std::endl;
+        return 1;
+    };
+    auto parse_count = [](std::string_view value, size_t& count)
+    {
+        auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), count);
+        return error == std::errc() && end == value.data() + value.size();
+    };
+
+    benchmark::Options options;
+    std::string json_path, csv_path, filter;
+    size_t group_by_rows = 1 << 20;
+    for (int i = 1; i < argc; i += 2)
+    {
+        std::string_view option = argv[i];
+        if (option != "--json" && option != "--csv" && option != "--filter" && option != "--repetitions" && option != "--warmup" &&
+            option != "--group-by-rows")
+        {
+            std::cerr << "unknown option: " << option << std::endl;
+            return usage();
+        }
+        if (i + 1 == argc)
+        {
+            std::cerr << "missing value for option: " << option << std::endl;
+            return usage();
+        }
+        std::string_view value = argv[i + 1];
+        if (option == "--json")
+            json_path = value;
+        else if (option == "--csv")
+            csv_path = value;
+        else if (option == "--filter")
+            filter = value;
+        else if (!parse_count(value, option == "--warmup" ? options.warmup : option == "--group-by-rows" ? group_by_rows : options.repetitions) ||
+                 options.repetitions == 0 || group_by_rows == 0)
+        {
+            std::cerr << "invalid value for " << option << ": " << value << std::endl;
+            return usage();
+        }
+    }
+
+    Suite suite {benchmark::Runner(options), filter};
+    if (!suite.runner.perf_available())
+        std::cout << "perf_event_open is not available: hardware counters are disabled" << std::endl;
+
+    Split(suite);
+    SmallVector(suite);
+    ToChars(suite);
+    AnyVariant(suite);
+    Square<int>(suite, "int");
+    Square<SFINAE::Number<float>>(suite, "Number<float>");
+    SquareBatch<float>(suite, "float");
+    SquareBatch<SFINAE::Number<float>>(suite, "Number<float>");
+    Contention(suite);
+    FlatMap(suite);
+    LookupCache(suite);
+    Queues(suite);
+    Encoding(suite);
+    MultiSearch(suite);
+    Radix(suite);
+    Pipeline(suite);
+    GroupBy(suite, group_by_rows);
+    Membership(suite);
+    PersonFile(suite);
+    Reflection(suite);
+    Trace(suite);
+    Format(suite);
+
+    if (!json_path.empty())
+    {
+        std::ofstream out(json_path);
+        benchmark::WriteJson(out, suite.runner.results());
+    }
+    if (!csv_path.empty())
+    {
+        std::ofstream out(csv_path);
+        benchmark::WriteCsv(out, suite.runner.results());
+    }
+    return 0;
+}
@@ -0,0 +1,394 @@
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+/*
+ Стоимость компиляции вариадических шаблонов: генерирует синтетические единицы трансляции (.cpp) с пачками из N аргументов/типов
+ в нескольких стилях, компилирует каждую и замеряет время и пиковую память компилятора (ru_maxrss дочернего процесса).
+ Стили:
+ - baseline           - только общая часть всех единиц (вычитается из остальных)
+ - fold Sum           - fold_expression::Sum(0, 1, ..., N-1): одна инстанциация
+ - recursive Sum      - fold_expression::RECURSIVE::Sum: N инстанциаций (до C++17)
+ - fold CountArgs     - fold_expression::CountArgs
+ - recursive CountArgs- fold_expression::RECURSIVE::CountArgs
+ - ENABLE_IF/CONSTEXPR/CONCEPT Square - Square для N разных типов Value<I>: N раз разрешение перегрузки (SFINAE, if constexpr, концепты)
+ Общая часть каждой единицы - <type_traits>, <utility> и копии замеряемых шаблонов из FoldExpression.h и SFINAE.h (Prelude), а не сами заголовки:
+ FoldExpression.h тянет Format.h, SmallVector.h и <iostream>, и их разбор (~1 с) заслоняет разницу стилей при N = 10-200.
+ Шаблоны в Prelude должны совпадать с заголовками.
+
+ Сборка: cmake --build build --target compile_benchmark
+ Запуск: ./build/compile_benchmark [--compiler c++] [--out compile_benchmark] [--sizes 10,100,500,1000] [--repetitions 3] [--syntax-only]
+ Результат: таблица в терминале, report.md и report.csv в каталоге --out
+ */
+
+namespace
+{
+    struct Options
+    {
+#if defined(CXX_COMPILER)
+        std::string compiler = CXX_COMPILER;
+#else
+        std::string compiler = "c++";
+#endif
+        std::filesystem::path out = "compile_benchmark";
+        std::vector<size_t> sizes = {10, 100, 500, 1000};
+        size_t repetitions = 3;
+        bool syntax_only = false;
+    };
+
+    struct Style
+    {
+        std::string_view name;
+        std::string (*body)(size_t size);
+    };
+
+    /// Замеряемые шаблоны: fold_expression::Sum/CountArgs и RECURSIVE (FoldExpression.h), SFINAE::*::Square (SFINAE.h)
+    constexpr std::string_view Prelude = R"(#include <type_traits>
+#include <utility>
+
+namespace fold_expression
+{
+    template<typename... Args>
+    inline constexpr auto Sum(Args... args)
+    {
+        return (args + ...);
+    }
+
+    template<typename ...Args>
+    inline constexpr int CountArgs(Args&& ...args)
+    {
+        return sizeof...(args);
+    }
+
+    namespace RECURSIVE
+    {
+        template<typename T>
+        inline constexpr auto Sum(T arg)
+        {
+            return arg;
+        }
+
+        template<typename T, typename... Args>
+        inline constexpr auto Sum(T first, Args... args)
+        {
+            return first + Sum(args...);
+        }
+
+        inline constexpr int CountArgs()
+        {
+            return 0;
+        }
+
+        template<typename T, typename ...Args>
+        inline constexpr int CountArgs(T&&, Args&& ...args)
+        {
+            return 1 + CountArgs(std::forward<Args>(args)...);
+        }
+    }
+}
+
+namespace SFINAE
+{
+    namespace ENABLE_IF
+    {
+        template<typename T>
+        typename std::enable_if<std::is_arithmetic<T>::value, T>::type Square(const T& number)
+        {
+            return number * number;
+        }
+
+        template<typename T>
+        typename std::enable_if<!std::is_arithmetic<T>::value, T>::type Square(const T& number)
+        {
+            return number.value * number.value;
+        }
+    }
+
+    namespace CONSTEXPR
+    {
+        template<typename T>
+        T Square(const T& number)
+        {
+            if constexpr (std::is_arithmetic<T>::value)
+                return number * number;
+            else
+                return number.value * number.value;
+        }
+    }
+
+    namespace CONCEPT
+    {
+        template<typename T>
+        concept Arithmetic = std::is_arithmetic<T>::value;
+
+        template <typename T>
+        concept has_member_value = requires (const T& t)
+        {
+            std::is_arithmetic<decltype(T::value)>::value;
+        };
+
+        template<Arithmetic T>
+        T Square(const T& number)
+        {
+            return number * number;
+        }
+
+        template<has_member_value T>
+        T Square(const T& number)
+        {
+            return number.value * number.value;
+        }
+    }
+}
+
+)";
+
+    /// 0, 1, ..., size-1
+    std::string Arguments(size_t size)
+    {
+        std::string result;
+        for (size_t i = 0; i < size; ++i)
+            result += (i ? ", " : "") + std::to_string(i);
+        return result;
+    }
+
+    /// Square для size разных типов: каждый Value<I> - отдельная инстанциация
+    std::string SquareBody(std::string_view name_space, size_t size)
+    {
+        std::ostringstream out;
+        out << "template<int I> struct Value { Value(int number) : value(number) {} int value; };\n\n"
+            << "template<int... I>\nint SquareAll(std::integer_sequence<int, I...>)\n{\n"
+            << "    return ((SFINAE::" << name_space << "::Square(Value<I>(I)).value + SFINAE::" << name_space << "::Square(I)) + ...);\n}\n\n"
+            << "int Run()\n{\n    return SquareAll(std::make_integer_sequence<int, " << size << ">());\n}\n";
+        return out.str();
+    }
+
+    const Style styles[] =
+    {
+        {"baseline", [](size_t) { return std::string("int Run()\n{\n    return 0;\n}\n"); }},
+        {"fold Sum", [](size_t size) { return "int Run()\n{\n    return fold_expression::Sum(" + Arguments(size) + ");\n}\n"; }},
+        {"recursive Sum", [](size_t size) { return "int Run()\n{\n    return fold_expression::RECURSIVE::Sum(" + Arguments(size) + ");\n}\n"; }},
+        {"fold CountArgs", [](size_t size) { return "int Run()\n{\n    return fold_expression::CountArgs(" + Arguments(size) + ");\n}\n"; }},
+        {"recursive CountArgs", [](size_t size) { return "int Run()\n{\n    return fold_expression::RECURSIVE::CountArgs(" + Arguments(size) + ");\n}\n"; }},
+        {"ENABLE_IF::Square", [](size_t size) { return SquareBody("ENABLE_IF", size); }},
+        {"CONSTEXPR::Square", [](size_t size) { return SquareBody("CONSTEXPR", size); }},
+        {"CONCEPT::Square", [](size_t size) { return SquareBody("CONCEPT", size); }},
+    };
+
+    struct Measurement
+    {
+        bool ok = false;
+        double milliseconds = 0; // медиана
+        double megabytes = 0;    // максимум пиковой памяти
+    };
+
+    /// Запуск компилятора: время и пиковая память дочернего процесса
+    bool Compile(const std::vector<std::string>& command, double& milliseconds, double& megabytes)
+    {
+#if defined(__unix__) || defined(__APPLE__)
+        std::vector<char*> argv;
+        for (const std::string& argument : command)
+            argv.push_back(const_cast<char*>(argument.c_str()));
+        argv.push_back(nullptr);
+
+        auto start = std::chrono::steady_clock::now();
+        pid_t pid = fork();
+        if (pid < 0)
+            return false;
+        if (pid == 0)
+        {
+            execvp(argv[0], argv.data());
+            _exit(127);
+        }
+
+        int status = 0;
+        rusage usage {};
+        if (wait4(pid, &status, 0, &usage) != pid)
+            return false;
+        milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+#if defined(__APPLE__)
+        megabytes = static_cast<double>(usage.ru_maxrss) / (1024.0 * 1024.0); // байты
+#else
+        megabytes = static_cast<double>(usage.ru_maxrss) / 1024.0; // килобайты
+#endif
+        return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+#else
+        (void)command;
+        (void)milliseconds;
+        (void)megabytes;
+        return false; // нужен fork/wait4
+#endif
+    }
+
+    Measurement Measure(const Options& options, const std::filesystem::path& source)
+    {
+        std::vector<std::string> command = {options.compiler, "-std=c++20", "-ftemplate-depth=4096"};
+        if (options.syntax_only)
+            command.insert(command.end(), {"-fsyntax-only", source.string()});
+        else
+            command.insert(command.end(), {"-c", source.string(), "-o", (options.out / "out.o").string()});
+
+        Measurement result;
+        std::vector<double> times;
+        for (size_t i = 0; i < std::max<size_t>(options.repetitions, 1); ++i)
+        {
+            double milliseconds = 0, megabytes = 0;
+            if (!Compile(command, milliseconds, megabytes))
+                return result;
+            times.push_back(milliseconds);
+            result.megabytes = std::max(result.megabytes, megabytes);
+        }
+        std::sort(times.begin(), times.end());
+        result.milliseconds = times[times.size() / 2];
+        result.ok = true;
+        return result;
+    }
+
+    /// Целое число без знака на всю строку
+    bool ParseCount(std::string_view text, size_t& count)
+    {
+        auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), count);
+        return error == std::errc() && end == text.data() + text.size();
+    }
+
+    /// "10,100,500": пустой результат - ошибка
+    std::vector<size_t> ParseSizes(std::string_view text)
+    {
+        std::vector<size_t> sizes;
+        while (!text.empty())
+        {
+            size_t comma = text.find(',');
+            size_t size = 0;
+            if (!ParseCount(text.substr(0, comma), size) || size == 0)
+                return {};
+            sizes.push_back(size);
+            text.remove_prefix(comma == std::string_view::npos ? text.size() : comma + 1);
+        }
+        return sizes;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    auto usage = [&]()
+    {
+        std::cerr << "usage: " << argv[0] << " [--compiler c++] [--out compile_benchmark] [--sizes 10,100,500,1000] [--repetitions 3] [--syntax-only]" << std::endl;
+        return 1;
+    };
+
+    Options options;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string_view option = argv[i];
+        if (option == "--syntax-only")
+        {
+            options.syntax_only = true;
+            continue;
+        }
+        if (i + 1 >= argc)
+        {
+            std::cerr << "missing value: " << option << std::endl;
+            return usage();
+        }
+        std::string_view value = argv[++i];
+        if (option == "--compiler")
+            options.compiler = value;
+        else if (option == "--out")
+            options.out = value;
+        else if (option == "--sizes" || option == "--repetitions")
+        {
+            if (option == "--sizes")
+                options.sizes = ParseSizes(value);
+            else if (!ParseCount(value, options.repetitions))
+                options.repetitions = 0;
+            if (options.sizes.empty() || options.repetitions == 0)
+            {
+                std::cerr << "invalid value for " << option << ": " << value << std::endl;
+                return usage();
+            }
+        }
+        else
+        {
+            std::cerr << "unknown option: " << option << std::endl;
+            return usage();
+        }
+    }
+
+    std::filesystem::create_directories(options.out);
+
+    // результаты[стиль][размер]
+    std::map<std::string_view, std::map<size_t, Measurement>> results;
+    for (size_t size : options.sizes)
+    {
+        for (const Style& style : styles)
+        {
+            std::string file_name(style.name);
+            std::replace_if(file_name.begin(), file_name.end(), [](char c) { return c == ' ' || c == ':'; }, '_');
+            std::filesystem::path source = options.out / (file_name + "_" + std::to_string(size) + ".cpp");
+            {
+                std::ofstream out(source);
+                out << "// " << style.name << ", N = " << size << "\n" << Prelude << style.body(size);
+            }
+
+            Measurement measurement = Measure(options, source);
+            results[style.name][size] = measurement;
+            std::cout << style.name << " [" << size << "]: ";
+            if (measurement.ok)
+                std::cout << measurement.milliseconds << " ms, " << measurement.megabytes << " MB" << std::endl;
+            else
+                std::cout << "compilation failed (" << source.string() << ")" << std::endl;
+        }
+    }
+
+    // Отчет: время и память каждого стиля, в скобках - разница с baseline того же размера
+    std::ofstream markdown(options.out / "report.md");
+    std::ofstream csv(options.out / "report.csv");
+    markdown << "# Compile time: " << options.compiler << (options.syntax_only ? " -fsyntax-only" : " -c") << "\n\n| style |";
+    for (size_t size : options.sizes)
+        markdown << " N = " << size << " |";
+    markdown << "\n|---|";
+    for (size_t i = 0; i < options.sizes.size(); ++i)
+        markdown << "---|";
+    markdown << '\n';
+    csv << "style,size,ok,milliseconds,megabytes,delta_milliseconds,delta_megabytes\n";
+
+    for (const Style& style : styles)
+    {
+        markdown << "| " << style.name << " |";
+        for (size_t size : options.sizes)
+        {
+            const Measurement& measurement = results[style.name][size];
+            const Measurement& baseline = results["baseline"][size];
+            double delta_time = measurement.milliseconds - baseline.milliseconds;
+            double delta_memory = measurement.megabytes - baseline.megabytes;
+
+            char cell[128];
+            if (measurement.ok)
+                std::snprintf(cell, sizeof(cell), " %.0f ms (%+.0f), %.0f MB (%+.1f) |", measurement.milliseconds, delta_time, measurement.megabytes, delta_memory);
+            else
+                std::snprintf(cell, sizeof(cell), " failed |");
+            markdown << cell;
+            csv << '"' << style.name << "\"," << size << ',' << measurement.ok << ',' << measurement.milliseconds << ',' << measurement.megabytes << ','
+                << delta_time << ',' << delta_memory << '\n';
+        }
+        markdown << '\n';
+    }
+
+    std::cout << "Report: " << (options.out / "report.md").string() << ", " << (options.out / "report.csv").string() << std::endl;
+    return 0;
+}
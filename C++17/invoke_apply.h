@@ -1,32 +1,36 @@
 #ifndef invoke_apply_h
 #define invoke_apply_h
 
+#include "Format.h"
+#include "Trace.h"
+
+#include <functional>
+#include <iostream>
+#include <tuple>
+#include <type_traits>
+
 namespace invoke_apply
 {
+    /// Типы, которые format::Print выводит так же, как std::cout: строки и целые, кроме bool и signed/unsigned char
+    template<typename T>
+    concept same_output_as_ostream = format::string_like<T> ||
+        (std::is_integral_v<T> && !std::is_same_v<T, bool> && !std::is_same_v<T, signed char> && !std::is_same_v<T, unsigned char>);
+
+    /*
+     Разделители выбираются на этапе компиляции: строка формата "{}, {}, ..., {}\n" из sizeof...(args) аргументов (Format.h).
+     Остальные типы - через std::cout, как раньше: bool выводится как 1/0, вещественные - с точностью потока (to_chars дал бы
+     кратчайшую форму), пользовательские типы - через свой operator<<.
+     */
     void print(const auto&... args)
     {
-        size_t index = sizeof...(args);
-        auto print = [&index](auto&& x)
+        if constexpr ((same_output_as_ostream<std::remove_cvref_t<decltype(args)>> && ...))
         {
-            std::cout << x;
-            if (index-- > 1)
-                std::cout << ", ";
-            else
-                std::cout << std::endl;
-        };
-        
-        (print(std::forward<decltype(args)>(args)), ...);
-    }
-
-    struct Print
-    {
-        int GetValue() noexcept { return value; }
-        void SetValue(int iValue) noexcept { value = iValue; }
-        
-        void operator()(auto&&... args)
+            format::Print<format::joined<sizeof...(args), ", ", "\n">>(args...);
+        }
+        else
         {
             size_t index = sizeof...(args);
-            auto print = [&index](auto&& x)
+            auto print = [&index](const auto& x)
             {
                 std::cout << x;
                 if (index-- > 1)
@@ -35,22 +39,23 @@ namespace invoke_apply
                     std::cout << std::endl;
             };
 
-            (print(std::forward<decltype(args)>(args)), ...);
+            (print(args), ...);
+        }
+    }
+
+    struct Print
+    {
+        int GetValue() noexcept { return value; }
+        void SetValue(int iValue) noexcept { value = iValue; }
+        
+        void operator()(auto&&... args)
+        {
+            invoke_apply::print(args...);
         }
         
         void print(const auto&... args)
         {
-            size_t index = sizeof...(args);
-            auto print = [&index](auto&& x)
-            {
-                std::cout << x;
-                if (index-- > 1)
-                    std::cout << ", ";
-                else
-                    std::cout << std::endl;
-            };
-            
-            (print(std::forward<decltype(args)>(args)), ...);
+            invoke_apply::print(args...);
         }
         
         int value;
@@ -59,6 +64,7 @@ namespace invoke_apply
     template<typename TFunction, typename... TArgs>
     decltype(auto) CallInvoke(TFunction&& function, TArgs&& ...args)
     {
+        TRACE_SCOPE("CallInvoke");
         // function(std::forward<TArgs>(args)...);
         return std::invoke(std::forward<TFunction>(function), std::forward<TArgs>(args)...);
     }
@@ -66,6 +72,7 @@ namespace invoke_apply
     template<typename TFunction, typename... TArgs>
     decltype(auto) CallApply(TFunction&& function, const std::tuple<TArgs...>& tuple)
     {
+        TRACE_SCOPE("CallApply");
         return std::apply(std::forward<TFunction>(function), tuple);
     }
 }
@@ -1,5 +1,24 @@
+#include "AllocationProfiler.h"
+#include "Encoding.h"
+#include "FlatMap.h"
 #include "FoldExpression.h"
+#include "Format.h"
+#include "GroupBy.h"
 #include "invoke_apply.h"
+#include "LookupCache.h"
+#include "MembershipFilter.h"
+#include "Metrics.h"
+#include "MultiSearch.h"
+#include "PersonFile.h"
+#include "Pipeline.h"
+#include "RadixSort.h"
+#include "Reflection.h"
+#include "RingBuffer.h"
+#include "SFINAE.h"
+#include "SharedString.h"
+#include "SmallVector.h"
+#include "StringView.h"
+#include "Trace.h"
 
 #include <algorithm>
 #include <array>
@@ -7,9 +26,15 @@
 #include <bitset>
 #include <cassert>
 #include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <optional>
+#include <random>
+#include <sstream>
 #include <string>
 #include <string_view>
 #include <thread>
@@ -90,155 +115,13 @@ namespace static_inline
         {
             [[maybe_unused]] static inline int i = 0;
         };
-    }
-}
-
-namespace SFINAE
-{
-    template <typename T>
-    struct Number
-    {
-        Number(const T& number) : value(number) {}
-
-        T value;
-    };
-
-    /*
-      Для Number<int> не работает: при вызове. Эта функция пытается найти int.value, которого не существует. Ошибку: часть else не удалена из функции (error: request for member ‘value’ in ‘t’, which is of non-class type ‘const int’).
-    */
-    namespace IS_ARITHMETIC
-    {
-        template<typename T>
-        T Square(const T& number)
-        {
-            if (std::is_arithmetic<T>::value)
-            {
-                return number * number;
-            }
-            else
-            {
-                return number.value * number.value;
-            }
-        }
-    }
-
-    /*
-    * C++14: Чтобы решить проблему Number<int>, нужны два шаблона функций, которые проверяют передаваемый тип на арифметическу.
-    */
-    namespace ENABLE_IF
-    {
-        template<typename T>
-        typename std::enable_if<std::is_arithmetic<T>::value, T>::type Square(const T& number)
-        {
-            return number * number;
-        }
-
-        template<typename T>
-        typename std::enable_if<!std::is_arithmetic<T>::value, T>::type Square(const T& number)
-        {
-            return number.value * number.value;
-        }
-
-        // template<typename T>
-        // typename std::enable_if<std::has_begin<T>::value, T>::type Square(const T& number)
-    }
 
-    /*
-      C++17: Здесь используется только один шаблон функции (что упрощает код вместо std::enable_if).
-      Компилятор берет только ветку с истинным условием (true) и отбрасывает другие.
-    */
-    namespace CONSTEXPR
-    {
-        template<typename T>
-        T Square(const T& number)
+        /// Глобальные метрики так же через static inline, но без общей кэш-линии: у каждого потока свой слот
+        struct Metrics
         {
-            if constexpr (std::is_arithmetic<T>::value) // Проверка нужна для класса Number, иначе ошибка: не найден operator*
-            {
-                return number * number;
-            }
-            else
-            {
-                return number.value * number.value;
-            }
-        }
-    }
-    /*
-      C++20: Концепты компилируются быстрее обычного SFINAE (std::enable_if и constexpr) и условия в них можно расширять. Версия C++20 вернулась обратно к двум функциям, но теперь код намного читабельнее, чем с std::enable_if.
-    */
-    namespace CONCEPT
-    {
-        template<typename T>
-        concept Arithmetic = std::is_arithmetic<T>::value;
-
-        template <typename T>
-        concept has_member_value = requires (const T& t)
-        {
-            std::is_arithmetic<decltype(T::value)>::value;
+            static inline metrics::Counter splits {"static_inline.splits"};
+            static inline metrics::Histogram split_ns {"static_inline.split_ns"};
         };
-
-        template<Arithmetic T>
-        T Square(const T& number)
-        {
-            return number * number;
-        }
-
-        template<has_member_value T>
-        T Square(const T& number)
-        {
-            return number.value * number.value;
-        }
-    }
-}
-
-namespace STRING_VIEW
-{
-    /*
-     Разделяет строку на слова через 2 указателя
-     Time: O(n)
-     Memory: O(n)
-     */
-    std::vector<std::string> split_by_space_string(const std::string& text, std::string delims = " ")
-    {
-        std::vector<std::string> result;
-        size_t first = 0;
-
-        while (first < text.size()) // проверяем указатель на выход за переделы
-        {
-            size_t second = text.find(delims, first); // поиск с определенного индекса
-            if (second == std::string::npos)
-                break;
-
-            if (first != second) // пробел найден
-                result.emplace_back(text.substr(first, second - first));
-
-            first = second + 1; // пропускаем пробел
-        }
-
-        return result;
-    }
-    /*
-     Разделяет строку на слова через 2 указателя
-     Time: O(n)
-     Memory: O(1) - string_view, но если строка изменится или выйдет за пределы видимости стека, то undefined behavior (UB).
-     */
-    std::vector<std::string_view> split_by_space_string_view(const std::string_view& text, const std::string_view& delims = " ")
-    {
-        std::vector<std::string_view> result;
-        size_t first = 0;
-
-        while (first < text.size()) // проверяем указатель на выход за переделы
-        {
-            size_t second = text.find(delims, first); // поиск с определенного индекса
-            if (second == std::string_view::npos)
-                break;
-            
-            if (first != second) // пробел найден
-                result.emplace_back(text.substr(first, second - first));
-
-            first = second + 1; // пропускаем пробел
-        }
-
-        return result;
     }
 }
 
@@ -272,6 +155,23 @@ int main()
             //auto [a, b] = std::map{ "hello", 1 };
             [[maybe_unused]] auto [title, year] = Example();
         }
+        // Рефлексия агрегатов через декомпозицию: число полей и обход полей без макросов
+        {
+            static_assert(reflection::field_count<Example> == 2);
+            static_assert(reflection::field_count<Person> == 3);
+
+            Person person {"Ivan", 30, {"Moscow", "Russia"}};
+            reflection::ForEachField(person.loc, [](const auto& field) { std::cout << field << " "; });
+            std::cout << std::endl;
+
+            std::string buffer = reflection::Serialize(person); // varint + строки с длиной, Person::loc - рекурсивно
+            Person copy {};
+            if (auto [ptr, ec] = reflection::Deserialize(buffer, copy); ec == std::errc())
+                std::cout << copy.name << " " << copy.age << " " << copy.loc.city << std::endl;
+
+            uint8_t small = 0; // число не помещается в поле - ошибка, а не усечение (сравнение скорости с ручным кодом - benchmark.cpp, группа reflection)
+            assert(reflection::Deserialize(reflection::Serialize(300), small).ec == std::errc::result_out_of_range && small == 0);
+        }
     }
     /*
      CTAD (class template argument deduction) - автоматическое определение типа параметра контейнера, без явного указания типа: вместо foo<...>(...) можно foo(...).
@@ -305,6 +205,28 @@ int main()
         {
             [[maybe_unused]] C17::Y y;
         }
+        // Счетчики, которые увеличивают все потоки
+        {
+            std::vector<std::thread> threads;
+            for (size_t t = 0; t < 4; ++t)
+            {
+                threads.emplace_back([]()
+                {
+                    for (size_t i = 0; i < 1'000; ++i)
+                    {
+                        auto start = std::chrono::steady_clock::now();
+                        [[maybe_unused]] auto words = STRING_VIEW::split_by_space_string_view("static inline metrics ");
+                        C17::Metrics::split_ns.Record(static_cast<uint64_t>(std::chrono::nanoseconds(std::chrono::steady_clock::now() - start).count()));
+                        C17::Metrics::splits.Increment();
+                    }
+                });
+            }
+            for (auto& thread : threads)
+                thread.join();
+
+            assert(C17::Metrics::splits.value() == 4'000);
+            metrics::WriteText(std::cout, metrics::Registry::Instance().Snapshot());
+        }
     }
     /*
      Fold expression (выражение свертки) - шаблон с заранее неизвестным числом аргументов (variadic template). Свертка – это функция, которая применяет заданную комбинирующую функцию к последовательным парам элементов в списке и возвращает результат. Любое выражение свёртки должно быть заключено в скобки и в общем виде выглядит так: (выражение содержащее пачку аргументов). Выражение внутри скобок должно содержать в себе нераскрытую пачку параметров и один из следующих операторов:
@@ -323,9 +245,30 @@ int main()
         [[maybe_unused]] auto norm_result = Norm(1, 2, 3);
         [[maybe_unused]] auto pow_sum_result = Pow_Sum(1, 2, 3);
         Push_To_Vector(numbers, 1, 2, 3, 4, 5);
+        containers::small_vector<int, 5> small_numbers;
+        Push_To_Vector(small_numbers, 1, 2, 3, 4, 5); // без выделения памяти в куче
         [[maybe_unused]] auto countArguments = CountArgs(1, "hello", 2.f);
         [[maybe_unused]] auto countTypes = CountTypes(1, "hello", 2.f);
+        static_assert(RECURSIVE::Sum(1, 2, 3) == Sum(1, 2, 3) && RECURSIVE::CountArgs(1, "hello", 2.f) == CountArgs(1, "hello", 2.f)); // до C++17: рекурсия
         CheckTypes(int(1), std::string("hello"), double(2.0));
+        Print(1, 2.5, "three"); // iostream: "1, 2.5, three, "
+        PrintFormat(1, 2.5, "three"); // тот же вывод, строка формата "{}, {}, {}, \n" собрана на этапе компиляции
+        format::Print<"{} = {}\n">("Sum(1, 2, 3)", Sum(1, 2, 3)); // число {} проверяется static_assert
+        assert((format::Format<"{{{}}}">(Sum(1, 2, 3)) == "{6}"));
+    }
+    /*
+     C++20 корутины: те же Sum/Average/Norm, но по потоку чисел из текста - конвейер чтение -> split -> from_chars -> подсчет с ограниченными каналами между стадиями (постоянная память)
+     */
+    {
+        using namespace fold_expression;
+
+        pipeline::ThreadPool pool(2);
+        std::istringstream in("1 2\n3\t4 5 12abc"); // разделители - любые пробельные символы, "12abc" - не число
+        auto aggregate = pipeline::Run(in, pool, {.chunk_size = 4, .capacity = 1});
+        assert(aggregate.count == 5);
+        assert(aggregate.Sum() == Sum(1., 2., 3., 4., 5.) && aggregate.Average() == Average(1., 2., 3., 4., 5.) && aggregate.Norm() == Norm(1., 2., 3., 4., 5.));
+        std::cout << "Pipeline: " << aggregate.count << " numbers, sum " << aggregate.Sum() << ", average " << aggregate.Average() << ", norm " << aggregate.Norm() << std::endl;
+        // пропускная способность и задержка до первого результата против материализации - benchmark.cpp (группа pipeline)
     }
     /*
      lambda - может быть constexpr, но с C++20 идет по-умолчанию, так что писать необязательно
@@ -380,6 +323,17 @@ int main()
             [[maybe_unused]] auto square5 = CONCEPT::Square(number_float); // Вызов Number<float> Square(Number<float>);
             [[maybe_unused]] auto square6 = CONCEPT::Square(number_boolean); // Вызов Number<bool>Square(Number<bool>);
         }
+        // C++20: пакетный Square(std::span) - SIMD-ядро выбирается концептом, массив Number<float> читается как массив float
+        {
+            std::vector<float> floats {1.f, 2.f, 3.f, 4.f, 5.f};
+            std::vector<Number<float>> numbers(floats.begin(), floats.end());
+            static_assert(CONCEPT::scalar_wrapper<Number<float>>);
+
+            auto squares = CONCEPT::Square(std::span<const float>(floats));
+            auto number_squares = CONCEPT::Square(std::span<const Number<float>>(numbers));
+            for (size_t i = 0; i < floats.size(); ++i)
+                assert(squares[i] == CONCEPT::Square(floats[i]) && number_squares[i].value == CONCEPT::Square(numbers[i]).value);
+        }
     }
     /*
      Тип std::byte - является более типобезопасным, чем char, unsigned char или uint8_t. К std::byte можно применить только побитовые операции, а арифметические операции и неявные преобразования недоступны. Использовать std::byte при работе с 'сырой' памятью, когда хранилище представляет собой просто последовательность байтов, а не массив символов
@@ -420,11 +374,25 @@ int main()
             return str_view;
         };
         
+#ifndef MAIN_CHECKS // в C++17_checks (ctest) не выполняется: чтение освобожденной памяти остановило бы проверку под -fsanitize=address
         std::string_view string_result = String(); // Выход за области видимости
         std::cout << string_result << std::endl; // Выведет мусор
+#else
+        (void)String;
+#endif
         
         std::string_view string_view_result = String_View(); // string_view владеет строкой
         std::cout << string_view_result << std::endl; // Выведет hello
+
+        /// Исправление String(): shared_slice держит счетчик ссылок буфера, поэтому срез переживает shared_string
+        auto Shared_String = [&]() -> containers::shared_slice
+        {
+            containers::shared_string str("Hello World, shared_slice!"); // одно выделение: счетчик + символы
+            return str.substr(0, 11); // срез без копирования символов
+        };
+        containers::shared_slice shared_result = Shared_String(); // буфер жив, пока жив срез
+        std::cout << shared_result << std::endl; // Выведет Hello World
+        assert(shared_result == "Hello World" && shared_result.use_count() == 1);
         
         std::string str("hello");
         std::string_view str_view(str);
@@ -453,6 +421,86 @@ int main()
         std::string text("some very long long text");
         std::vector<std::string> words_string = split_by_space_string(text);
         std::vector<std::string_view> words_string_view = split_by_space_string_view(text);
+
+        /// small_vector: до N слов хранятся внутри объекта, без выделения памяти в куче
+        {
+            containers::small_vector<std::string_view, 8> words_small_vector;
+            split_by_space_string_view(text, words_small_vector);
+            assert(std::ranges::equal(words_small_vector, words_string_view)); // как и split_by_space_string_view: "text" без пробела в конце не попадает в результат
+            containers::small_vector<std::string, 8> words_string_small_vector;
+            split_by_space_string(text, words_string_small_vector);
+
+            {
+                allocation_profiler::Scope scope("small_vector split");
+                containers::small_vector<std::string_view, 8> request;
+                split_by_space_string_view("GET /index.html HTTP/1.1 ", request);
+                assert(request.size() == 3 && scope.WithinBudget(0)); // 3 слова внутри объекта; сравнение с std::vector - benchmark.cpp (группа small_vector)
+            }
+        }
+        /// Замер выделений памяти на 1 МБ текста: string копирует каждое слово, string_view - только растит вектор
+        {
+            std::string big_text;
+            for (size_t i = 0; i < 50'000; ++i)
+                big_text += "internationalization "; // слово длиннее SSO-буфера (15 символов) не помещается в сам std::string
+
+            allocation_profiler::Counters string_counters, string_view_counters;
+            {
+                allocation_profiler::Scope scope("split_by_space_string", &std::cout); // строка JSON при выходе из области
+                [[maybe_unused]] auto words = split_by_space_string(big_text);
+                string_counters = scope.counters();
+            }
+            {
+                allocation_profiler::Scope scope("split_by_space_string_view", &std::cout);
+                [[maybe_unused]] auto words = split_by_space_string_view(big_text);
+                string_view_counters = scope.counters();
+            }
+            assert(string_view_counters.allocations < 64); // только рост вектора: O(log(n)) выделений
+            assert(string_view_counters.allocations < string_counters.allocations);
+
+            // shared_slice: выделения как у string_view (символы копируются один раз в shared_string), но слова владеют буфером
+            const containers::shared_string shared_text(big_text);
+            allocation_profiler::Counters shared_slice_counters;
+            std::vector<containers::shared_slice> shared_words;
+            {
+                allocation_profiler::Scope scope("split_by_space_shared_slice", &std::cout);
+                shared_words = split_by_space_shared_slice(shared_text);
+                shared_slice_counters = scope.counters();
+            }
+            assert(shared_slice_counters.allocations < 64);
+            assert(shared_words.size() == 50'000 && shared_text.use_count() == 50'001);
+            assert(split_by_space_shared_slice(containers::shared_string("some\ttext"), " \t").size() == 2); // разделители - набор символов, последнее слово - в результате
+
+            // Срезы можно передать в другой поток: содержимое неизменяемо, счетчик атомарный
+            size_t shared_length = 0;
+            std::thread worker([&shared_length, words = std::move(shared_words)]()
+            {
+                for (const containers::shared_slice& word : words)
+                    shared_length += word.size();
+            });
+            worker.join();
+            assert(shared_length == 50'000 * std::string_view("internationalization").size());
+            assert(shared_text.use_count() == 1); // срезы уничтожены вместе с лямбдой потока
+        }
+    }
+    /*
+     Бинарный файл записей Person: mmap + std::string_view на отображенную память вместо разбора текста и копирования строк.
+     */
+    {
+        const auto path = std::filesystem::temp_directory_path() / "persons.bin";
+        {
+            person_file::Writer writer(path);
+            writer.Write(Person{"Ivan", 30, {"Moscow", "Russia"}});
+            writer.Write(Person{"Mary", 25, {"London", "UK"}});
+        }
+        {
+            person_file::Reader reader(path);
+            for (size_t i = 0; i < reader.size(); ++i)
+            {
+                auto [name, age, loc] = reader[i]; // PersonView: поля ссылаются на файл, пока жив reader
+                std::cout << name << " " << age << " " << loc.city << std::endl;
+            }
+        }
+        std::filesystem::remove(path); // загрузка 10M записей, холодный и теплый старт - benchmark.cpp (группа person_file)
     }
     /*
      std::variant - тип данных, который умеет хранить и объединять в себе несколько типов данных.
@@ -584,6 +632,26 @@ int main()
 
             lambda(flag.value());
         }
+        /// Пример 6: мемоизация поиска, возвращающего std::optional - ограниченный кэш с вытеснением CLOCK
+        {
+            lookup_cache::ClockCache<int> cache(2);
+            cache.put("one", 1);
+            cache.put("two", 2);
+            [[maybe_unused]] auto one = cache.get("one"); // std::optional<int>: 1, поиск по string_view без создания std::string
+            cache.put("three", 3); // вытеснена "two": к ней не было обращений
+            std::cout << cache.get("two").value_or(-1) << std::endl; // -1
+            cache.erase("three");
+            cache.put("four", 4); // занимает освобожденную ячейку, "one" не вытесняется
+            assert(cache.get("one") == 1 && cache.get("four") == 4);
+            auto statistics = cache.statistics();
+            std::cout << "hits: " << statistics.hits << " misses: " << statistics.misses << " evictions: " << statistics.evictions << std::endl;
+            
+            lookup_cache::ShardedClockCache<size_t> sharded(1'000);
+            [[maybe_unused]] auto length = sharded.get_or_compute("hello", [](std::string_view key) { return key.size(); }); // вычисляется один раз
+            statistics = sharded.statistics();
+            std::cout << "sharded hits: " << statistics.hits << " misses: " << statistics.misses << " evictions: " << statistics.evictions << std::endl;
+            // сравнение с std::unordered_map под мьютексом в 1..hardware_concurrency потоках - benchmark.cpp (группа lookup_cache)
+        }
     }
     /// Получение неконстантной ссылки на внутренние данные std::string с помощью метода data(). Однако data() вернет строку без нуля в конце
     {
@@ -623,6 +691,19 @@ int main()
          reset() - сброс значения
         */
        {
+           /// Пример 0: std::any хранит большой объект в куче, std::variant - внутри себя
+           {
+               {
+                   allocation_profiler::Scope scope("std::variant", &std::cout);
+                   [[maybe_unused]] std::variant<int, std::array<char, 64>> variant = std::array<char, 64>{};
+                   assert(scope.WithinBudget(0));
+               }
+               {
+                   allocation_profiler::Scope scope("std::any", &std::cout);
+                   [[maybe_unused]] std::any any = std::array<char, 64>{};
+                   assert(!scope.WithinBudget(0));
+               }
+           }
            /// Пример 1: без проверки на тип
            {
                std::any any = 42;
@@ -672,6 +753,16 @@ int main()
                    std::cout << "a is another type or unset" << std::endl;
                }
            }
+           /// Пример 4: реестр только для чтения на flat_map - ключи и значения лежат в непрерывных массивах, поиск по string_view без создания std::string
+           {
+               containers::flat_map<std::string, std::any> registry({{"integer", 10}, {"string", std::string("Hello World")}, {"float", 1.0f}});
+               if (auto it = registry.find(std::string_view("integer")); it != registry.end())
+                   std::cout << it.key() << ": " << std::any_cast<int>(it.value()) << std::endl;
+               // вставка по string_view: std::string создается только для нового ключа
+               registry.insert(std::string_view("double"), 2.0);
+               assert(registry.size() == 4 && std::any_cast<double>(registry.at(std::string_view("double"))) == 2.0);
+               // сравнение поиска с std::map на 1K-100M ключей - benchmark.cpp (группа flat_map)
+           }
        }
     }
     /// Атрибуты nodiscard, fallthrough, maybe_unused
@@ -775,6 +866,11 @@ int main()
             std::cout << num << ' ';
         std::cout << std::endl;
     }
+    /*
+     Трассировка: с этого места CallInvoke/CallApply, split и критические секции scoped_lock пишутся в trace.json (открыть в ui.perfetto.dev или chrome://tracing).
+     */
+    const std::filesystem::path trace_path = std::filesystem::temp_directory_path() / "C++17.trace.json";
+    trace::Exporter trace_exporter(trace_path);
     // invoke & apply
     {
         using namespace invoke_apply;
@@ -919,11 +1015,13 @@ int main()
         auto function1 = [&]()
             {
                 std::scoped_lock scoped_lock(mutex1, mutex2);
+                TRACE_SCOPE("scoped_lock(mutex1, mutex2)");
                 std::this_thread::sleep_for(std::chrono::milliseconds(10)); // задержка, чтобы thread2 успел сделать lock в mutex2 в function2
             };
         auto function2 = [&]()
             {
                 std::scoped_lock scoped_lock(mutex2, mutex1); // порядок неважен
+                TRACE_SCOPE("scoped_lock(mutex2, mutex1)");
                 std::this_thread::sleep_for(std::chrono::milliseconds(10)); // задержка, чтобы thread1 успел сделать lock в mutex1
             };
         std::thread thread1(function1);
@@ -931,6 +1029,287 @@ int main()
 
         thread1.join();
         thread2.join();
+
+        TRACE_COUNTER("split words", static_cast<int64_t>(STRING_VIEW::split_by_space_string_view("trace the split in the same file").size()));
+        std::cout << "Trace: " << trace_path << std::endl;
+    }
+    /*
+     Lock-free очереди: SPSC кольцо (один производитель, один потребитель) и ограниченная MPMC очередь (Vyukov).
+     Элементы перемещаются на место в ячейке, поэтому подходят move-only типы, например std::unique_ptr<int> из CreateNumber().
+     Blocking = true: push/pop ждут на std::atomic::wait (futex) вместо мьютекса и condition_variable.
+     */
+    {
+        std::cout << "Ring buffers" << std::endl;
+        constexpr size_t count = 1000;
+
+        concurrent::SpscRing<std::unique_ptr<int>, true> ring(64);
+        std::thread producer([&]()
+        {
+            for (size_t i = 0; i < count; ++i)
+                ring.push(CreateNumber());
+        });
+        int sum = 0;
+        for (size_t i = 0; i < count; ++i)
+            sum += *ring.pop();
+        producer.join();
+        assert(sum == static_cast<int>(count));
+
+        concurrent::MpmcQueue<std::unique_ptr<int>, true> queue(64);
+        std::vector<std::thread> producers;
+        for (size_t p = 0; p < 2; ++p)
+            producers.emplace_back([&]()
+            {
+                for (size_t i = 0; i < count; ++i)
+                    queue.push(CreateNumber());
+            });
+        std::atomic<int> total = 0;
+        std::vector<std::thread> consumers;
+        for (size_t c = 0; c < 2; ++c)
+            consumers.emplace_back([&]()
+            {
+                std::vector<std::unique_ptr<int>> numbers;
+                while (numbers.size() < count)
+                    if (!queue.try_pop_n(std::back_inserter(numbers), count - numbers.size()))
+                        std::this_thread::yield();
+                for (const auto& number : numbers)
+                    total += *number;
+            });
+        for (auto& thread : producers)
+            thread.join();
+        for (auto& thread : consumers)
+            thread.join();
+        assert(total == 2 * static_cast<int>(count));
+    }
+    /*
+     Кириллица: Windows-1251 <-> UTF-8 целыми буферами вместо посимвольного преобразования через локаль (setlocale в начале main).
+     Выход - буфер вызывающего, ошибки - в encoding::Result (позиция, сколько уже записано).
+     */
+    {
+        std::cout << "Encoding" << std::endl;
+        const std::string_view utf8 = "Съешь же ещё этих мягких французских булок, да выпей чаю — «C++17»";
+
+        std::vector<char> cp1251(utf8.size());
+        encoding::Result result = encoding::Utf8ToCp1251(utf8, cp1251);
+        assert(result && result.read == utf8.size() && result.written < utf8.size());
+        cp1251.resize(result.written);
+
+        std::vector<char> back(encoding::MaxUtf8Size(cp1251.size()));
+        result = encoding::Cp1251ToUtf8(std::string_view(cp1251.data(), cp1251.size()), back);
+        assert(result && std::string_view(back.data(), result.written) == utf8);
+
+        assert(encoding::ValidateUtf8(utf8));
+        assert(encoding::ValidateUtf8("ok\xD0").error == encoding::Error::Truncated);
+        result = encoding::Utf8ToCp1251("ок \xF0\x9F\x98\x80", cp1251); // эмодзи нет в CP1251
+        assert(result.error == encoding::Error::Unmappable && result.read == 5 && result.written == 3);
+
+        // Случайные куски текста (начало и конец - где угодно, в том числе посреди символа), испорченный байт, нехватка выхода:
+        // блочные версии (SSE2/SSSE3 - что выбрано для процессора) совпадают с посимвольными SCALAR по результату и по записанному
+        std::mt19937 generator(42);
+        const std::string text = encoding::MakeRussianText(16 << 10, 0.3);
+        for (int round = 0; round < 2000; ++round)
+        {
+            std::string input = text.substr(generator() % text.size(), generator() % 100);
+            if (!input.empty() && generator() % 4 == 0)
+                input[generator() % input.size()] = static_cast<char>(generator());
+            const size_t size = generator() % 3 ? input.size() : generator() % (input.size() + 1);
+            std::vector<char> fast(size), slow(size);
+
+            [[maybe_unused]] encoding::Result expected = encoding::SCALAR::Utf8ToCp1251(input, slow);
+            assert(encoding::Utf8ToCp1251(input, fast) == expected && std::equal(slow.begin(), slow.begin() + expected.written, fast.begin()));
+            assert(encoding::ValidateUtf8(input) == encoding::SCALAR::ValidateUtf8(input));
+
+            // CP1251: А-я вперемешку с любыми байтами (0x98 не определен), выход - MaxUtf8Size или меньше
+            for (char& c : input)
+                c = static_cast<char>(generator() % 2 ? 0xC0 + generator() % 64 : generator());
+            fast.resize(generator() % 3 ? encoding::MaxUtf8Size(input.size()) : generator() % (encoding::MaxUtf8Size(input.size()) + 1));
+            slow.resize(fast.size());
+            expected = encoding::SCALAR::Cp1251ToUtf8(input, slow);
+            assert(encoding::Cp1251ToUtf8(input, fast) == expected && std::equal(slow.begin(), slow.begin() + expected.written, fast.begin()));
+        }
+
+        std::cout << std::endl;
+    }
+    /*
+     Поиск многих подстрок за один проход: split_by_space_string_view ищет один разделитель (text.find), а в строках журнала нужны
+     десятки ключевых слов сразу. Результат сверяется с циклом text.find по каждой подстроке (search::Naive).
+     */
+    {
+        std::cout << "Multi-pattern search" << std::endl;
+        const std::string log = search::MakeLog(64 << 10);
+        const std::vector<std::string> keywords = {"ERROR", "WARN", "refused", "timeout", "id=", " ms\n"};
+
+        search::Searcher searcher(keywords); // до 16 подстрок - Teddy
+        assert(searcher.engine() == search::Engine::Teddy && searcher.FindAll(log) == search::Naive(keywords, log));
+
+        std::vector<std::string> many = keywords;
+        for (int i = 0; i < 100; ++i)
+            many.push_back("key=" + std::to_string(i));
+        search::Searcher automaton(many); // больше - Aho-Corasick
+
+        // По частям, как при чтении из сокета: вхождения на стыках не теряются
+        search::Searcher::Stream stream(automaton);
+        std::vector<search::Match> matches;
+        for (size_t position = 0; position < log.size(); position += 1000)
+            stream.Feed(std::string_view(log).substr(position, 1000), [&matches](const search::Match& match) { matches.push_back(match); });
+        std::sort(matches.begin(), matches.end());
+        assert(matches == search::Naive(many, log));
+
+        // Teddy по частям от 0 до 8 байт: вхождение начинается в хвосте прошлых частей и заканчивается в новой (или через одну)
+        search::Searcher::Stream teddy(searcher);
+        matches.clear();
+        std::mt19937 generator(42);
+        for (size_t position = 0; position < log.size();)
+        {
+            const size_t size = generator() % 9;
+            teddy.Feed(std::string_view(log).substr(position, size), [&matches](const search::Match& match) { matches.push_back(match); });
+            position += size;
+        }
+        std::sort(matches.begin(), matches.end());
+        assert(matches == search::Naive(keywords, log));
+
+        // Случайные наборы коротких подстрок из 3 символов (много перекрытий и общих начал) против Naive: оба движка, целиком и по частям
+        for (int round = 0; round < 500; ++round)
+        {
+            std::string text(generator() % 200, 'a');
+            for (char& c : text)
+                c = "ab\n"[generator() % 3];
+            std::vector<std::string> patterns(1 + generator() % 16);
+            for (std::string& pattern : patterns)
+                for (size_t length = 1 + generator() % 5; pattern.size() < length;)
+                    pattern += "ab\n"[generator() % 3];
+
+            for (search::Engine engine : {search::Engine::Teddy, search::Engine::AhoCorasick})
+            {
+                const search::Searcher random(patterns, engine);
+                [[maybe_unused]] const std::vector<search::Match> expected = search::Naive(patterns, text);
+                assert(random.FindAll(text) == expected);
+
+                search::Searcher::Stream stream(random);
+                std::vector<search::Match> found;
+                for (size_t position = 0; position < text.size();)
+                {
+                    const size_t size = generator() % 9;
+                    stream.Feed(std::string_view(text).substr(position, size), [&found](const search::Match& match) { found.push_back(match); });
+                    position += size;
+                }
+                std::sort(found.begin(), found.end());
+                assert(found == expected);
+            }
+        }
+
+        std::cout << std::endl;
+    }
+    /*
+     Сортировка Person по (age, name): std::sort переставляет записи целиком (три std::string на обмен), radix сортирует пары
+     (age, индекс) по разрядам, затем имена внутри равного возраста по символам (MSD), а записи переставляет один раз.
+     TopK - первые k без сортировки остальных.
+     */
+    {
+        std::cout << "Radix sort" << std::endl;
+        std::mt19937 generator(42);
+        constexpr std::string_view syllables[] = {"an", "na", "va", "iv", "ma", "ri", "ol", "ga", "se", "rg", "ei", "dm"};
+        std::vector<Person> persons(500'000);
+        for (Person& person : persons)
+        {
+            for (size_t i = 0, length = 2 + generator() % 4; i < length; ++i)
+                person.name += syllables[generator() % std::size(syllables)];
+            person.age = static_cast<uint32_t>(generator() % 100);
+            person.loc = {"Moscow", "Russia"};
+        }
+
+        auto name = [](const Person& person) -> const std::string& { return person.name; };
+        std::vector<radix::Index> top = radix::TopK(persons, 3, &Person::age, name);
+        for (radix::Index index : top)
+            std::cout << persons[index].age << " " << persons[index].name << std::endl;
+
+        std::vector<Person> sorted = persons;
+        radix::Permute(sorted, radix::SortIndices(sorted, &Person::age, name)); // записи перемещаются один раз
+        assert(std::is_sorted(sorted.begin(), sorted.end(), [](const Person& left, const Person& right)
+        {
+            return std::tie(left.age, left.name) < std::tie(right.age, right.name);
+        }));
+        assert(sorted.front().name == persons[top.front()].name);
+
+        std::cout << std::endl;
+    }
+    /*
+     Группировка: число людей и средний возраст по стране. std::map<std::string, ...> - поиск по дереву и строка на каждую запись,
+     group_by::GroupBy - хэш-таблица по std::string_view, агрегаты собираются на этапе компиляции, потоки считают свои таблицы.
+     */
+    {
+        std::cout << "Group by" << std::endl;
+        const std::pair<std::string_view, std::string_view> locations[] = {{"Moscow", "Russia"}, {"Kazan", "Russia"}, {"London", "UK"}, {"Paris", "France"}};
+        std::mt19937 generator(42);
+        std::vector<Person> persons(100'000);
+        for (Person& person : persons)
+        {
+            auto [city, country] = locations[generator() % std::size(locations)];
+            person = {"name", static_cast<uint32_t>(18 + generator() % 60), {std::string(city), std::string(country)}};
+        }
+
+        constexpr auto country = [](const Person& person) -> std::string_view { return person.loc.country; };
+        group_by::GroupBy<country, group_by::Count, group_by::Average<&Person::age>, group_by::Max<&Person::age, uint32_t>> query;
+        query.Add(persons);
+        std::map<std::string, uint64_t, std::less<>> counts;
+        query.Finish([&counts](std::string_view key, uint64_t count, double average, uint32_t oldest)
+        {
+            std::cout << key << ": " << count << " persons, average age " << average << ", oldest " << oldest << std::endl;
+            counts.emplace(key, count);
+        });
+
+        // Групп больше max_groups - таблицы сбрасываются на диск по разделам, результат тот же
+        constexpr auto city = [](const Person& person) -> std::string_view { return person.loc.city; };
+        group_by::Options options;
+        options.max_groups = 2;
+        options.partitions = 4;
+        group_by::GroupBy<city, group_by::Count> spilled(options);
+        spilled.Add(persons);
+        uint64_t russia = 0;
+        group_by::Stats stats = spilled.Finish([&russia](std::string_view key, uint64_t count)
+        {
+            if (key == "Moscow" || key == "Kazan")
+                russia += count;
+        });
+        assert(stats.spilled_groups > 0 && stats.groups == std::size(locations) && russia == counts["Russia"]);
+        std::cout << stats.groups << " cities, " << stats.spilled_groups << " groups spilled (" << stats.spilled_bytes << " bytes)" << std::endl;
+
+        std::cout << std::endl;
+    }
+    /*
+     Фильтр принадлежности перед реестром std::map<std::string, std::any>: промах (большинство поисков) отсекается фильтром
+     за несколько наносекунд без прохода по дереву. BloomFilter - меньше памяти, CuckooFilter - поддерживает удаление.
+     */
+    {
+        std::cout << "Membership filter" << std::endl;
+        using Registry = std::map<std::string, std::any, std::less<>>;
+        Registry map;
+        map["integer"] = 10;
+        map["string"] = std::string("Hello World");
+        map["float"] = 1.0f;
+
+        membership::Filtered<Registry> registry(map, membership::BloomFilter(1'000, 0.01));
+        assert(registry.contains("integer") && !registry.contains("double"));
+        if (auto it = registry.find("string"); it != registry.end())
+            std::cout << it->first << ": " << std::any_cast<std::string>(it->second) << std::endl;
+
+        // Contains/find - только чтение: несколько потоков без блокировок
+        std::atomic<size_t> hits = 0;
+        std::vector<std::jthread> readers;
+        for (size_t i = 0; i < 2; ++i)
+            readers.emplace_back([&registry, &hits]()
+            {
+                for (std::string_view key : {"integer", "string", "float", "double", "long"})
+                    hits += registry.contains(key);
+            });
+        readers.clear();
+        assert(hits == 6);
+
+        membership::Filtered<Registry, membership::CuckooFilter<>> cuckoo(std::move(map), membership::CuckooFilter<>(1'000));
+        cuckoo.insert("double", 2.0);
+        cuckoo.erase("float");
+        assert(cuckoo.contains("double") && !cuckoo.contains("float") && !cuckoo.filter().Contains("float"));
+
+        std::cout << std::endl;
     }
 
     return 0;